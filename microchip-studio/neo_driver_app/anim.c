@@ -18,6 +18,9 @@
 bool b_animReset = true;               // Used by mode logic to inform animations to reset
 bool b_animCycleComplete = false;      // Signal from animations to mode logic
 uint8_t u8_nextSleepTime = WDT_16MS;   // Data from terminating animations to mode logic
+uint16_t u16_nextFrameTime = 0;        // Data from animations to frame scheduler. millis() deadline of the next frame.
+uint8_t u8_frameWdt = ANIM_FRAME_WDT_NONE; // Data from animations to frame scheduler. Longest watchdog step (WDT_XXX) the
+                                       // frame period tolerates in power-down. Reset before each frame, set by opt-in anims.
 
 /****************************** FLASH CONSTANTS ******************************/
 // NOTE: If these are defined in the header file instead, they get placed in flash twice!
@@ -38,7 +41,6 @@ static const uint8_t PROGMEM sz_frames3[] = "jklmnopq";      // Starburst ( 1234
 static const uint8_t PROGMEM sz_frames4[] = "rs";            // Frog      ( 12   :  rs )
 static const uint8_t PROGMEM sz_frames5[] = "`a";            // Turbine   ( 12   :  `a )
 static const uint8_t PROGMEM sz_frames6[] = "b/-\\";         // Spinner
-static const uint8_t PROGMEM sz_frames6_alt[] = "\\-/b";     // Spinner ALT
 static const uint8_t PROGMEM sz_frames7[] = "ef";            // DNA       ( 12    :  ef    )
 static const uint8_t PROGMEM sz_frames8[] = ")*+,.";         // Snowfall  ( 12345 :  )*+,. )
 static const uint8_t PROGMEM sz_frames9[] = ":@=[=;";        // Field     ( 12345  :  :;=@[  ) [143532]
@@ -66,7 +68,13 @@ FRAMES_CONFIG_T st_sequence1 = {
     -4,
     0,
     1,
-    0
+    0,
+
+    // Power params
+    ANIM_FRAME_WDT_NONE,
+
+    // Display params
+    false
 };
 
 // Sequence 2 - Ghost
@@ -84,7 +92,13 @@ FRAMES_CONFIG_T st_sequence2 = {
     -4,
     0,
     1,
-    0
+    0,
+
+    // Power params
+    ANIM_FRAME_WDT_NONE,
+
+    // Display params
+    false
 };
 
 // Sequence 3 - Starburst
@@ -102,7 +116,13 @@ FRAMES_CONFIG_T st_sequence3 = {
     0,
     0,
     0,
-    0
+    0,
+
+    // Power params
+    ANIM_FRAME_WDT_NONE,
+
+    // Display params
+    false
 };
 
 // Sequence 4 - Frog
@@ -120,7 +140,13 @@ FRAMES_CONFIG_T st_sequence4 = {
     -4,
     0,
     1,
-    0
+    0,
+
+    // Power params
+    ANIM_FRAME_WDT_NONE,
+
+    // Display params
+    false
 };
 
 // Sequence 5 - Turbine
@@ -138,7 +164,13 @@ FRAMES_CONFIG_T st_sequence5 = {
     0,
     0,
     0,
-    0
+    0,
+
+    // Power params
+    ANIM_FRAME_WDT_NONE,
+
+    // Display params
+    false
 };
 
 // Sequence 6 - Spinner
@@ -156,7 +188,13 @@ FRAMES_CONFIG_T st_sequence6 = {
     0,
     0,
     0,
-    0
+    0,
+
+    // Power params
+    ANIM_FRAME_WDT_NONE,
+
+    // Display params
+    false
 };
 
 // Sequence 7 - DNA
@@ -174,7 +212,13 @@ FRAMES_CONFIG_T st_sequence7 = {
     0,
     0,
     0,
-    0
+    0,
+
+    // Power params
+    ANIM_FRAME_WDT_NONE,
+
+    // Display params
+    false
 };
 
 // Sequence 8 - Snowfall
@@ -192,7 +236,13 @@ FRAMES_CONFIG_T st_sequence8 = {
     0,
     0,
     0,
-    0
+    0,
+
+    // Power params
+    WDT_64MS,
+
+    // Display params
+    false
 };
 
 // Sequence 9 - Field
@@ -210,7 +260,13 @@ FRAMES_CONFIG_T st_sequence9 = {
     0,
     0,
     0,
-    0
+    0,
+
+    // Power params
+    WDT_64MS,
+
+    // Display params
+    false
 };
 
 // Sequence 10 - Ball
@@ -228,25 +284,52 @@ FRAMES_CONFIG_T st_sequence10 = {
     0,
     0,
     0,
-    0
+    0,
+
+    // Power params
+    ANIM_FRAME_WDT_NONE,
+
+    // Display params
+    false
 };
 
+/****************************** STATIC VARS ******************************/
+// Shader state. Set up by the animation each frame, then stepped by its shader as show() streams the pixels.
+static uint8_t u8_shadePos;             // Pattern position of the pixel being shaded
+static uint8_t u8_shadeStep;            // Position step per pixel, integer part
+static uint8_t u8_shadeStepRem;         // Position step per pixel, remainder (in 1/u8_shadeNumPix)
+static uint8_t u8_shadeRem;             // Accumulated remainder
+static uint8_t u8_shadeNumPix;          // Pixel count of the frame
+static uint8_t u8_shadeThird1;          // Primaries: color boundaries, 1/3 and 2/3 of the pixel count
+static uint8_t u8_shadeThird2;
+
+/*************************** STATIC PROTOTYPES ***************************/
+static void     anim_shade_setup(uint8_t u8_startPos, uint16_t u16_span);
+static uint8_t  anim_shade_next(void);
+static uint32_t shade_primaries(uint8_t u8_pixIdx);
+static uint32_t shade_half(uint8_t u8_pixIdx);
+static uint32_t shade_marquee(uint8_t u8_pixIdx);
+static uint32_t shade_sine_gamma(uint8_t u8_pixIdx);
+
 /******************************** FUNCTIONS ********************************/
 
 // All NeoPixels off
 void anim_off() {
     np_clear();
+
+    u16_nextFrameTime = millis() + ANIM_FRAME_MIN_MSEC;
 }
 
 void anim_white() {
     np_fill_all(0xFFFFFF);
+
+    u16_nextFrameTime = millis() + ANIM_FRAME_MIN_MSEC;
 }
 
 // Cycle through primary colors (red, green, blue), full brightness.
 void anim_primaries() {
     static uint16_t u16_startTime;
     static uint8_t u8_direction;        // Direction of the anim. (0, 1 : CW, CCW)
-    uint32_t u32_color;
     uint16_t u16_currTime = millis();
     uint16_t u16_currTimeMod = u16_currTime;
     uint8_t  u8_numPixels = np_get_length();
@@ -263,21 +346,18 @@ void anim_primaries() {
     // Negating this value will cause it to decrease instead of increase with time
     if (u8_direction) { u16_currTimeMod = -u16_currTimeMod; }
 
-    // Generate time-modulated animation
-    for (uint8_t u8_pixIdx = 0; u8_pixIdx < u8_numPixels; u8_pixIdx++) {
-        uint8_t u8_pixIdxMod = u8_pixIdx;
-
-        // Time modulated pixel index
-        // Tick every 100 mSec
-        u8_pixIdxMod = ((u16_currTimeMod / 100) + u8_pixIdxMod) % u8_numPixels;
-
-        // Approx 1/3 R,G,B at any one time
-        // Where does our modulated pixel index fall on the color wheel?
-        if      (u8_pixIdxMod < u8_numPixels/3)    u32_color = 0xFF0000; // Red
-        else if (u8_pixIdxMod < 2*u8_numPixels/3)  u32_color = 0x00FF00; // Green
-        else                                       u32_color = 0x0000FF; // Blue
-        np_set_pix_color_pack(u8_pixIdx, u32_color);
-    }
+    // Generate time-modulated animation, computed per pixel while streaming
+    // Time modulated index of pixel 0, ticks every PRIM_STEP_MSEC
+    u8_shadeNumPix = u8_numPixels;
+    u8_shadePos = (u16_currTimeMod / PRIM_STEP_MSEC) % u8_numPixels;
+    u8_shadeThird1 = u8_numPixels/3;
+    u8_shadeThird2 = 2*u8_numPixels/3;
+    np_set_shader(shade_primaries);
+
+    // Next frame is due on the next tick of the modulated time, in either direction
+    uint8_t u8_tickRem = u16_currTimeMod % PRIM_STEP_MSEC;
+    if (u8_direction) { u16_nextFrameTime = u16_currTime + u8_tickRem + 1; }
+    else              { u16_nextFrameTime = u16_currTime + PRIM_STEP_MSEC - u8_tickRem; }
 
     // Signal mode logic of cycle completion
     if (u16_currTime - u16_startTime > PRIM_ON_TIME_MSEC) {
@@ -307,11 +387,24 @@ void anim_colorwheel_gamma() {
     // Negating this value will cause it to decrease instead of increase with time
     if (u8_direction) { u16_currTimeMod = -u16_currTimeMod; }
 
+    // Hue offset of each pixel is u8_pixIdx * 65536 / u8_numPixels. Step it by the quotient and carry
+    // the remainder, so there is no divide (or multiply) inside the loop.
+    uint16_t u16_hue = u16_currTimeMod * 50;
+    uint16_t u16_hueStep = 65536L / u8_numPixels;
+    uint8_t  u8_hueStepRem = 65536L % u8_numPixels;
+    uint8_t  u8_hueRem = 0;
+
     // Generate time-modulated animation
     for (uint8_t u8_pixIdx = 0; u8_pixIdx < u8_numPixels; u8_pixIdx++) {
-        np_set_pix_color_pack(u8_pixIdx, np_get_gamma_32(np_hsv_to_pack_hue((u16_currTimeMod * 50) + u8_pixIdx * 65536L / u8_numPixels)));
+        np_set_pix_color_pack(u8_pixIdx, np_hue_to_pack_gamma(u16_hue));
+
+        u16_hue += u16_hueStep;
+        u8_hueRem += u8_hueStepRem;
+        if (u8_hueRem >= u8_numPixels) { u8_hueRem -= u8_numPixels; u16_hue++; }
     }
 
+    u16_nextFrameTime = u16_currTime + ANIM_FRAME_MIN_MSEC;
+
     // Signal mode logic of cycle completion
     if (u16_currTime - u16_startTime > COL_WHEEL_ON_TIME_MSEC) {
         b_animCycleComplete = true;
@@ -340,15 +433,13 @@ void anim_half() {
     // Negating this value will cause it to decrease instead of increase with time
     if (u8_direction) { u16_currTimeMod = -u16_currTimeMod; }
 
-    // Generate time-modulated animation
-    for (uint8_t u8_pixIdx = 0; u8_pixIdx < u8_numPixels; u8_pixIdx++) {
+    // Generate time-modulated animation, computed per pixel while streaming
+    // Time modulated pixel index: u16_currTimeMod/4 + u8_pixIdx * 256 / u8_numPixels
+    u8_shadeNumPix = u8_numPixels;
+    anim_shade_setup(u16_currTimeMod/4, 256);
+    np_set_shader(shade_half);
 
-        // Time modulated pixel index
-        uint8_t u8_pixIdxMod = u16_currTimeMod/4 + u8_pixIdx * 256 / u8_numPixels;
-        u8_pixIdxMod = (u8_pixIdxMod >> 7) * 255;                     // ON or OFF
-
-        np_set_pix_color_pack(u8_pixIdx, u8_pixIdxMod * 0x010000);
-    }
+    u16_nextFrameTime = u16_currTime + ANIM_FRAME_MIN_MSEC;
 
     // Signal mode logic of cycle completion
     if (u16_currTime - u16_startTime > HALF_ON_TIME_MSEC) {
@@ -399,6 +490,8 @@ void anim_sparkle() {
         np_set_pix_color(u8_pixIdx, u8_red, u8_green, u8_blue);
     }
 
+    u16_nextFrameTime = u16_lastTime + SPK_STEP_MSEC + 1;
+
     // Signal mode logic of cycle completion
     if (u16_currTime - u16_startTime > SPK_ON_TIME_MSEC) {
         b_animCycleComplete = true;
@@ -427,15 +520,13 @@ void anim_marquee() {
     // Negating this value will cause it to decrease instead of increase with time
     if (u8_direction) { u16_currTimeMod = -u16_currTimeMod; }
 
-    // Generate time-modulated animation
-    for (uint8_t u8_pixIdx = 0; u8_pixIdx < u8_numPixels; u8_pixIdx++) {
-
-        // Time modulated pixel index
-        uint8_t u8_pixIdxMod = (u16_currTimeMod/4 + u8_pixIdx * 256 / u8_numPixels) & 0xFF;
-        u8_pixIdxMod = ((u8_pixIdxMod >> 6) & 1) * 255;
+    // Generate time-modulated animation, computed per pixel while streaming
+    // Time modulated pixel index: u16_currTimeMod/4 + u8_pixIdx * 256 / u8_numPixels
+    u8_shadeNumPix = u8_numPixels;
+    anim_shade_setup(u16_currTimeMod/4, 256);
+    np_set_shader(shade_marquee);
 
-        np_set_pix_color_pack(u8_pixIdx, u8_pixIdxMod * 0x000100L);
-    }
+    u16_nextFrameTime = u16_currTime + ANIM_FRAME_MIN_MSEC;
 
     // Signal mode logic of cycle completion
     if (u16_currTime - u16_startTime > MARQUEE_ON_TIME_MSEC) {
@@ -465,15 +556,13 @@ void anim_sine_gamma() {
     // Negating this value will cause it to decrease instead of increase with time
     if (u8_direction) { u16_currTimeMod = -u16_currTimeMod; }
 
-    // Generate time-modulated animation
-    for (uint8_t u8_pixIdx = 0; u8_pixIdx < u8_numPixels; u8_pixIdx++) {
-
-        // Time modulated pixel index
-        uint8_t u8_pixIdxMod = np_get_sine_8((u16_currTimeMod/4 + u8_pixIdx * 512 / u8_numPixels) & 0xFF);
-        u8_pixIdxMod = np_get_gamma_8(u8_pixIdxMod);
+    // Generate time-modulated animation, computed per pixel while streaming
+    // Time modulated pixel index: u16_currTimeMod/4 + u8_pixIdx * 512 / u8_numPixels (two sine periods)
+    u8_shadeNumPix = u8_numPixels;
+    anim_shade_setup(u16_currTimeMod/4, 512);
+    np_set_shader(shade_sine_gamma);
 
-        np_set_pix_color_pack(u8_pixIdx, u8_pixIdxMod * 0x000100L);
-    }
+    u16_nextFrameTime = u16_currTime + ANIM_FRAME_MIN_MSEC;
 
     // Signal mode logic of cycle completion
     if (u16_currTime - u16_startTime > SINE_ON_TIME_MSEC) {
@@ -516,13 +605,16 @@ void anim_cov(uint8_t u8_pattType) {
         u8_stepCount = 0;
     }
 
+    // Coarse fade steps, so the frame scheduler can power down in between
+    u16_currTime -= (u16_currTime - u16_lastTime) % COV_FRAME_MSEC;
+
     // Map time elapsed 0-COV_STEP_MSEC (msec) to sine index 0-255
     uint8_t u8_cycle = (u16_currTime - u16_lastTime)*255L / COV_STEP_MSEC;
 
     // Shift sine wave right by 64 to get off-on-off cycle
     uint8_t u8_cBright = np_get_gamma_8(np_get_sine_8(u8_cycle - 64));
 
-    np_clear();
+    if (u8_pattType == 0) { np_clear(); }               // The char pattern is sent as a mono frame
     uint8_t u8_numPixels = np_get_length();
     uint8_t u8_quarter = u8_numPixels/4;                // Quarter of pixels
 
@@ -531,22 +623,26 @@ void anim_cov(uint8_t u8_pattType) {
     {
     case 0: // A (Grn)
         if      (u8_pattType == 0) { np_fill(u8_cBright * 0x000100L, 0, u8_quarter); }  // Force 32-bit mult
-        else if (u8_pattType == 1) { draw_char_cent('A', u8_cBright * 0x000100L); }
+        else if (u8_pattType == 1) { np_set_mono(draw_char_mask('A', 0, 0), u8_cBright * 0x000100L); }
         break;
     case 1: // C (Blu)
         if      (u8_pattType == 0) { np_fill(u8_cBright * 0x000001L, u8_quarter, u8_quarter); }
-        else if (u8_pattType == 1) { draw_char_cent('C', u8_cBright * 0x000001L); }
+        else if (u8_pattType == 1) { np_set_mono(draw_char_mask('C', 0, 0), u8_cBright * 0x000001L); }
         break;
     case 2: // G (Yel)
         if      (u8_pattType == 0) { np_fill(u8_cBright * 0x010100L, 2*u8_quarter, u8_quarter); }
-        else if (u8_pattType == 1) { draw_char_cent('G', u8_cBright * 0x010100L); }
+        else if (u8_pattType == 1) { np_set_mono(draw_char_mask('G', 0, 0), u8_cBright * 0x010100L); }
         break;
     case 3: // U (Red)
         if      (u8_pattType == 0) { np_fill(u8_cBright * 0x010000L, 3*u8_quarter, 0); }
-        else if (u8_pattType == 1) { draw_char_cent('U', u8_cBright * 0x010000L); }
+        else if (u8_pattType == 1) { np_set_mono(draw_char_mask('U', 0, 0), u8_cBright * 0x010000L); }
         break;
     }
 
+    // Brightness steps every COV_FRAME_MSEC
+    u16_nextFrameTime = u16_currTime + COV_FRAME_MSEC;
+    u8_frameWdt = COV_FRAME_WDT;
+
     // Current step complete
     if (u16_currTime - u16_lastTime > COV_STEP_MSEC) {
 
@@ -568,35 +664,33 @@ void anim_cov(uint8_t u8_pattType) {
 
 // Message string 1
 void anim_msg_1() {
-    anim_msg(sz_msg1, COLOR_PURPLE);
+    anim_msg(sz_msg1, false, COLOR_PURPLE);
 }
 
 // Message string 2
 void anim_msg_2() {
-    anim_msg(sz_msg2, COLOR_WHEEL);
+    anim_msg(sz_msg2, false, COLOR_WHEEL);
 }
 
 // Message string 3
 void anim_msg_3() {
-    anim_msg(sz_msg3, COLOR_WHEEL);
+    anim_msg(sz_msg3, false, COLOR_WHEEL);
 }
 
 // Message string 4
 void anim_msg_4() {
-    anim_msg(sz_msg4, COLOR_GREEN);
+    anim_msg(sz_msg4, false, COLOR_GREEN);
 }
 
 /*!
  @brief            Supporting function for the message scroll animations.
- @param pu8_msg    Starting address for a null-terminated C-String with the message, stored in flash.
+ @param pu8_msg    Starting address for a null-terminated C-String with the message, any length.
+ @param b_eep      true: the message is in EEPROM. false: it is in flash.
  @param u32_color  Solid color to use for the characters. Use COLOR_WHEEL for a smooth color cycling anim.
 */
-void anim_msg(const uint8_t* pu8_msg, uint32_t u32_color) {
-    static uint8_t  u8_charCnt; // Counts 0 to LEN-1, index into char array
-    static uint8_t  u8_cIn;     // Incoming char
-    static uint8_t  u8_cOut;    // Outgoing char
-    static int8_t   i8_xIn;
-    static int8_t   i8_xOut;
+void anim_msg(const uint8_t* pu8_msg, bool b_eep, uint32_t u32_color) {
+    static DRAW_SCROLL_T st_scroll;
+    static uint32_t u32_mask;   // Blit of the scroll window, only changes on a step
     static uint16_t u16_lastTime;
     static bool     b_readyToShutdown;
 
@@ -605,49 +699,30 @@ void anim_msg(const uint8_t* pu8_msg, uint32_t u32_color) {
     // New transition into this anim, reset all vars to starting values
     if (b_animReset) {
         b_animReset = false;
-        u8_charCnt = 0;
-        u8_cIn  = pgm_read_byte(&pu8_msg[0]);
-        u8_cOut = ' ';
-        i8_xIn  = 5;
-        i8_xOut = 0;
+        draw_scroll_start(&st_scroll, pu8_msg, b_eep);
+        u32_mask = 0;
         u16_lastTime  = u16_currTime;
         b_readyToShutdown = false;
     }
 
-    // Iterate animation once per step
+    // Iterate animation once per step, shifting in one column
     if (u16_currTime - u16_lastTime >= MSG_STEP_MSEC) {
         u16_lastTime = u16_currTime;
 
-        if (i8_xIn == 0) {     // Incoming char has reached middle
-            u8_cOut = u8_cIn;  // Incoming becomes outgoing
-
-            // Fetch next char
-            u8_charCnt++;
-            u8_cIn = pgm_read_byte(&pu8_msg[u8_charCnt]);
-
-            // Reached null term, current cycle complete
-            if (u8_cIn == 0) {
-
-                b_readyToShutdown = true;
-            }
-
-            // Reset positions
-            i8_xIn  = 6;
-            i8_xOut = 0;
-        }
-
-        i8_xIn--; i8_xOut--;  // Shift both chars left
+        // Reached null term, current cycle complete
+        if (draw_scroll_step(&st_scroll)) { u32_mask = draw_bb_to_mask(st_scroll.bb_window); }
+        else                              { b_readyToShutdown = true; }
     }
 
-    // Pick color to use
+    // Pick color to use, and when the next frame is due
     uint32_t u32_c;
-    if (u32_color == COLOR_WHEEL) { u32_c = np_get_gamma_32(np_hsv_to_pack_hue(u16_currTime*10)); } // Smooth time-modulated color wheel
-    else                          { u32_c = u32_color; }                                            // Solid color from calling func
+    if (u32_color == COLOR_WHEEL) { u32_c = np_hue_to_pack_gamma(u16_currTime*10);   // Smooth time-modulated color wheel
+                                    u16_nextFrameTime = u16_currTime + ANIM_FRAME_MIN_MSEC; }
+    else                          { u32_c = u32_color;                                             // Solid color from calling func
+                                    u16_nextFrameTime = u16_lastTime + MSG_STEP_MSEC; }
 
-    // Render characters at current pos, no vertical offset
-    np_clear();
-    draw_char(u8_cIn,  u32_c, i8_xIn, 0);
-    draw_char(u8_cOut, u32_c, i8_xOut, 0);
+    // Render the scroll window
+    np_set_mono(u32_mask, u32_c);
 
     // Signal mode logic of cycle completion
     if (b_readyToShutdown) {
@@ -786,17 +861,22 @@ void anim_frames(FRAMES_CONFIG_T* pst_f) {
         
     }
 
-    // Pick color to use
+    // Pick color to use, and when the next frame is due
     uint32_t u32_color;
-    if (pst_f->u32_color == COLOR_WHEEL) {
-        u32_color = np_get_gamma_32(np_hsv_to_pack_hue(u16_currTime*10)); // Smooth time-modulated color wheel
+    if ((pst_f->u32_color == COLOR_WHEEL) && (pst_f->u8_frameWdt == ANIM_FRAME_WDT_NONE)) {
+        u32_color = np_hue_to_pack_gamma(u16_currTime*10); // Smooth time-modulated color wheel
+        u16_nextFrameTime = u16_currTime + ANIM_FRAME_MIN_MSEC;
     } else {
-        u32_color = pst_f->u32_color; // Solid color from spec
+        if (pst_f->u32_color == COLOR_WHEEL) { u32_color = np_hue_to_pack_gamma(u16_lastFrameTime*10); } // Stepped color wheel
+        else                                 { u32_color = pst_f->u32_color; }  // Solid color from spec
+        u16_nextFrameTime = u16_lastFrameTime + pst_f->u16_frameStep_msec;
+        u8_frameWdt = pst_f->u8_frameWdt;
     }
 
     // Render frame
-    np_clear();
-    draw_char(u8_currFrame, u32_color, i8_x, i8_y);
+    DRAW_BB_T bb = draw_char_bb(u8_currFrame);
+    if (pst_f->b_flipH) { bb = draw_bb_flip_h(bb); }
+    np_set_mono(draw_bb_to_mask(draw_bb_shift(bb, i8_x, i8_y)), u32_color);
 
     // Signal mode logic of cycle completion
     if (b_readyToShutdown) {
@@ -838,25 +918,28 @@ void anim_batt_level() {
         }
     }
 
-    np_clear();
+    u16_nextFrameTime = u16_lastStepTime + BATT_LVL_STEP_MSEC + 1;
 
     // Render current frame
     switch (u8_stepLevel)
     {
     case 1:
-        draw_char_cent(BATT_ICON_LVL_1, COLOR_RED);
+        np_set_mono(draw_char_mask(BATT_ICON_LVL_1, 0, 0), COLOR_RED);
         break;
     case 2:
-        draw_char_cent(BATT_ICON_LVL_2, COLOR_YELLOW);
+        np_set_mono(draw_char_mask(BATT_ICON_LVL_2, 0, 0), COLOR_YELLOW);
         break;
     case 3:
-        draw_char_cent(BATT_ICON_LVL_3, COLOR_YELLOW);
+        np_set_mono(draw_char_mask(BATT_ICON_LVL_3, 0, 0), COLOR_YELLOW);
         break;
     case 4:
-        draw_char_cent(BATT_ICON_LVL_4, COLOR_GREEN);
+        np_set_mono(draw_char_mask(BATT_ICON_LVL_4, 0, 0), COLOR_GREEN);
         break;
     case 5:
-        draw_char_cent(BATT_ICON_LVL_5, COLOR_GREEN);
+        np_set_mono(draw_char_mask(BATT_ICON_LVL_5, 0, 0), COLOR_GREEN);
+        break;
+    default:
+        np_set_mono(0, 0);
         break;
     }
 
@@ -885,7 +968,7 @@ void shuffle_anim_params() {
         st_sequence4.i8_shiftStepX = -st_sequence4.i8_shiftStepX;
 
         // Reverse spinner direction
-        st_sequence6.pu8_frames = sz_frames6_alt;
+        st_sequence6.b_flipH = true;
         
         // Reverse ball direction
         st_sequence10.pu8_frames = sz_frames10_alt;
@@ -893,9 +976,67 @@ void shuffle_anim_params() {
     } else {
 
         // Restore spinner direction
-        st_sequence6.pu8_frames = sz_frames6;
+        st_sequence6.b_flipH = false;
 
         // Restore ball direction
         st_sequence10.pu8_frames = sz_frames10;
     }
 }
+
+
+/********************************* SHADERS *********************************/
+// Called by np_show() for each pixel in order, with interrupts disabled. Keep these short, see np_shader_t.
+
+/*!
+ @brief             Set up the shader stepping for a frame. Pixel i gets position
+                    u8_startPos + i * u16_span / u8_shadeNumPix (mod 256), stepped
+                    with a carried remainder so there is no divide per pixel.
+                    u8_shadeNumPix must be set first.
+ @param u8_startPos Position of pixel 0
+ @param u16_span    Position range covered by the whole strip
+*/
+static void anim_shade_setup(uint8_t u8_startPos, uint16_t u16_span) {
+    u8_shadePos = u8_startPos;
+    u8_shadeStep = u16_span / u8_shadeNumPix;
+    u8_shadeStepRem = u16_span % u8_shadeNumPix;
+    u8_shadeRem = 0;
+}
+
+// Returns the position of the current pixel and steps to the next one
+static uint8_t anim_shade_next(void) {
+    uint8_t u8_pos = u8_shadePos;
+
+    u8_shadePos += u8_shadeStep;
+    u8_shadeRem += u8_shadeStepRem;
+    if (u8_shadeRem >= u8_shadeNumPix) { u8_shadeRem -= u8_shadeNumPix; u8_shadePos++; }
+
+    return u8_pos;
+}
+
+static uint32_t shade_primaries(uint8_t u8_pixIdx) {
+    (void)u8_pixIdx;    // Steps its own position
+    uint8_t u8_pixIdxMod = u8_shadePos;
+
+    if (++u8_shadePos >= u8_shadeNumPix) { u8_shadePos = 0; }
+
+    // Approx 1/3 R,G,B at any one time
+    // Where does our modulated pixel index fall on the color wheel?
+    if      (u8_pixIdxMod < u8_shadeThird1)  return 0xFF0000; // Red
+    else if (u8_pixIdxMod < u8_shadeThird2)  return 0x00FF00; // Green
+    else                                     return 0x0000FF; // Blue
+}
+
+static uint32_t shade_half(uint8_t u8_pixIdx) {
+    (void)u8_pixIdx;    // Steps its own position
+    return (anim_shade_next() & 0x80) ? 0xFF0000 : 0;          // ON or OFF
+}
+
+static uint32_t shade_marquee(uint8_t u8_pixIdx) {
+    (void)u8_pixIdx;    // Steps its own position
+    return (anim_shade_next() & 0x40) ? 0x00FF00 : 0;
+}
+
+static uint32_t shade_sine_gamma(uint8_t u8_pixIdx) {
+    (void)u8_pixIdx;    // Steps its own position
+    return (uint32_t)np_get_gamma_8(np_get_sine_8(anim_shade_next())) << 8;
+}
@@ -16,7 +16,12 @@ extern "C"{
 #endif
 
 /********************************** DEFINES **********************************/
+// Frame scheduling
+#define ANIM_FRAME_MIN_MSEC    (20)             // Frame period for continuously moving (time-modulated) animations
+#define ANIM_FRAME_WDT_NONE    (0xFF)           // u8_frameWdt: frame timing needs Timer0, idle sleep only
+
 // Primaries
+#define PRIM_STEP_MSEC         (100)            // Time between pixel shifts
 #define PRIM_ON_TIME_MSEC      (6000)           // "on" time between sleeps
 #define PRIM_SLEEP_TIME        (WDT_8S)         // Time to sleep after this anim
 
@@ -46,9 +51,11 @@ extern "C"{
 #define COV_STEP_CNT           (4)                      // Number of steps (bases) per cycle
 #define COV_BASES_CNT          (EEP_COV_DATA_NUM_BYTES * 4)     // 4 bases per byte
 #define COV_SLEEP_TIME         (WDT_8S)
+#define COV_FRAME_MSEC         (64)                     // Fade step, coarse enough to power down between frames
+#define COV_FRAME_WDT          (WDT_64MS)
 
 // Message Scroll
-#define MSG_STEP_MSEC          (200)                    // Time to shift each char left by one pixel
+#define MSG_STEP_MSEC          (200)                    // Time to shift the message left by one column
 #define MSG_SLEEP_TIME         (WDT_24S)
 
 // Frames
@@ -87,6 +94,13 @@ typedef struct {
     int8_t   i8_startPosY;        // 
     int8_t   i8_shiftStepX;       // The X shift to perform on each shift step. Can be pos, neg, or zero.
     int8_t   i8_shiftStepY;       // The Y shift to perform on each shift step. Can be pos, neg, or zero.
+
+    // Power params
+    uint8_t  u8_frameWdt;         // Longest WDT_XXX step to power down for between frames, or ANIM_FRAME_WDT_NONE.
+                                  // With COLOR_WHEEL, a coarse sequence changes color once per frame, not continuously.
+
+    // Display params
+    bool     b_flipH;             // Mirror the frames left-right. Turns a spinner the other way.
     
 } FRAMES_CONFIG_T;
 
@@ -108,7 +122,7 @@ void anim_msg_1();
 void anim_msg_2();
 void anim_msg_3();
 void anim_msg_4();
-void anim_msg(const uint8_t* pu8_msg, uint32_t u32_color);
+void anim_msg(const uint8_t* pu8_msg, bool b_eep, uint32_t u32_color);
 void anim_frames_1();
 void anim_frames_2();
 void anim_frames_3();
@@ -50,6 +50,37 @@ extern "C"{
 // Computes to 125.
 #define nanosecondsPerClockCycle() ( 1000000000UL / F_CPU )
 
+/*
+ * System clock (see clock_set())
+ *
+ * F_CPU is the default clock, 8 MHz. All compile-time timing is based on it.
+ * CLK_SEL_1MHZ is always available. np_show() raises the clock to F_CPU for the transmit.
+ * CLK_PLL_EN: Define when the CKSEL fuses select the 16 MHz PLL clock (CKSEL = 0001, lfuse 0xF1).
+ *             init() divides it to 8 MHz, and clock_set(CLK_SEL_16MHZ) can run at full speed.
+ *             The PLL stays on while awake, so idle current is higher at 8 MHz too.
+ */
+// #define CLK_PLL_EN
+
+/*
+ * Tickless Timer0
+ *
+ * TIMER0_TICKLESS_EN defined:   Timer0 runs at F_CPU / 1024 (128 usec tick) and overflows every 32.8 msec instead
+ *                               of every 2 msec. millis() adds the counter value, and idle sleep is woken at the
+ *                               next deadline by timer0_wake_at(). micros() resolution drops to the tick.
+ * TIMER0_TICKLESS_EN undefined: Timer0 runs at F_CPU / 64 (8 usec tick), millis() counts in overflows.
+ */
+#define TIMER0_TICKLESS_EN
+#ifdef TIMER0_TICKLESS_EN
+  #define MICROS_RES_USEC   (128)   // Worst case micros() resolution, at any clock_set() speed
+#else
+  #define MICROS_RES_USEC   (8)
+#endif
+#define CLK_SEL_1MHZ        (0)
+#define CLK_SEL_8MHZ        (1)
+#define CLK_SEL_16MHZ       (2)
+// Safe operating area is 10 MHz at 2.7 V to 20 MHz at 4.5 V. 16 MHz needs about 3.8 V.
+#define CLK_16MHZ_MIN_MV    (3800)
+
 #define clockCyclesToMicroseconds(a) ( (a) / clockCyclesPerMicrosecond() )
 #define microsecondsToClockCycles(a) ( (a) * clockCyclesPerMicrosecond() )
 
@@ -76,8 +107,14 @@ void init(void);
 
 uint32_t millis(void);
 uint32_t micros(void);
+void millis_advance(uint16_t ms);
 void delay_msec(uint32_t ms);
 void delay_usec(uint16_t us);
+void delay_usec_idle(uint16_t us);
+void timer0_wake_at(uint16_t u16_msec);
+
+bool clock_set(uint8_t u8_clkSel);
+uint8_t clock_get(void);
 
 void setup(void);
 void loop(void);
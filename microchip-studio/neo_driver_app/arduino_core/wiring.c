@@ -28,55 +28,83 @@
 
 #include <Arduino.h>
 #include <avr/boot.h>
+#include <avr/sleep.h>
 #include <wiring_analog.h>
 
 /****************************** DEFINES ******************************/
+#ifdef TIMER0_TICKLESS_EN
+// Timer0 is running at 8 MHz / 1024 = 7.8 KHz, overflowing every 32.8 msec
+#define TIMER0_PRESCALER        (0b101)
+#define TIMER0_PRESCALER_VALUE  (1024)
+// At CLK_SEL_1MHZ, Timer0 runs at 1 MHz / 64 = 15.6 KHz. There is no /128, so the tick is halved.
+#define TIMER0_PRESCALER_1MHZ   (0b011)
+#define TIMER0_TICK_SHIFT_1MHZ  (TIMER0_TICK_SHIFT - 1)
+#else
 // Timer0 is running at 8 MHz / 64 = 125 KHz
 #define TIMER0_PRESCALER        (0b011)
 #define TIMER0_PRESCALER_VALUE  (64)
+// At CLK_SEL_1MHZ, Timer0 runs at 1 MHz / 8 = 125 KHz, so the tick stays at 8 usec
+#define TIMER0_PRESCALER_1MHZ   (0b010)
+#define TIMER0_TICK_SHIFT_1MHZ  (TIMER0_TICK_SHIFT)
+#endif
 
-// the prescaler is set so that the millis timer ticks every TIMER0_PRESCALER_VALUE (64) clock cycles, and the
+// the prescaler is set so that the millis timer ticks every TIMER0_PRESCALER_VALUE (64 or 1024) clock cycles, and the
 // the overflow handler is called every 256 ticks. (Timer0 is an 8-bit timer/counter)
 // The key is never to compute (F_CPU / 1000000L), which may lose precision.
 // The formula below is correct for all F_CPU times that evenly divide by 10,
-// at least for prescaler values up and including 64 as used in this file.
-// Computes to 2048 usec
+// at least for prescaler values up and including 1024 as used in this file.
+// Computes to 2048 usec (32768 usec tickless)
 #define MICROSECONDS_PER_MILLIS_OVERFLOW \
     (TIMER0_PRESCALER_VALUE * 256UL * 1000UL * 100UL / ((F_CPU + 5UL) / 10UL))
 
-// Computes to 8.
+// Computes to 8 (128 tickless).
 #define MICROSECONDS_PER_TIMER0_TICK (TIMER0_PRESCALER_VALUE / clockCyclesPerMicrosecond())
+// log2 of the above, for the F_CPU clock. The tick is halved at CLK_SEL_16MHZ.
+#ifdef TIMER0_TICKLESS_EN
+#define TIMER0_TICK_SHIFT            (7)
+#else
+#define TIMER0_TICK_SHIFT            (3)
+#endif
 
+#if ((1 << TIMER0_TICK_SHIFT) != MICROSECONDS_PER_TIMER0_TICK)
+  #error "TIMER0_TICK_SHIFT does not match F_CPU"
+#endif
 
-// The whole number of milliseconds per millis timer overflow.
-// Computes to 2 msec.
-#define MILLIS_INC (MICROSECONDS_PER_MILLIS_OVERFLOW / 1000U)
+// delay_usec() busy loop: log2 of iterations (4 cycles each) per usec, for the F_CPU clock
+#define DELAY_USEC_SHIFT             (1)
 
-// the fractional number of milliseconds per millis timer overflow. we shift right
-// by three to fit these numbers into a byte. (for the clock speeds we care
-// about - 8 and 16 MHz - this doesn't lose precision.)
-// Computes to 6.
-#define FRACT_INC ((MICROSECONDS_PER_MILLIS_OVERFLOW % 1000U) >> 3)
-// Computes to 125.
-#define FRACT_MAX (1000U >> 3)
+// System clock prescaler (CLKPR) values
+#define CLKPR_DIV_1                  (0b0000)
+#define CLKPR_DIV_2                  (0b0001)
+#define CLKPR_DIV_8                  (0b0011)
+#define CLKPR_DIV_16                 (0b0100)
 
 
 /****************************** GLOBALS ******************************/
-static volatile uint32_t millis_timer_overflow_count = 0;
 static volatile uint32_t millis_timer_millis = 0;
-static volatile uint8_t millis_timer_fract = 0;
+static volatile uint16_t millis_timer_fract = 0;    // usec past millis_timer_millis
+static volatile uint32_t micros_timer_usec = 0;     // micros() at the last overflow
+
+// Clock dependent, see clock_set(). Timer0 keeps its prescaler from 8 MHz up, so its tick length follows the clock.
+static uint8_t           clock_sel = CLK_SEL_8MHZ;
+static uint8_t           timer0_tick_shift = TIMER0_TICK_SHIFT;                     // log2(usec per tick)
+static uint16_t          timer0_ovf_usec = MICROSECONDS_PER_MILLIS_OVERFLOW;        // usec per overflow
+static volatile int16_t  timer0_ovf_adjust = 0;     // Correction for the next overflow, after a clock change mid-period
+static uint8_t           delay_usec_shift = DELAY_USEC_SHIFT;
 
 
 /************************** STATIC PROTOTYPES **************************/
 static void timer0_init();
+static inline void timer0_ovf_service();
+static inline void timer0_carry_msec(uint32_t* pm, uint16_t* pf);
 
 /****************************** FUNCTIONS ******************************/
 static void timer0_init()
 {
     // Timer0 Setup for millis() and micros():
-    // Use the Millis Timer for fast PWM (unless it doesn't have an output).
-    // if Timer0 has PWM
-    TCCR0A = (1<<WGM01) | (1<<WGM00);
+    // Normal mode. The PWM outputs are not used (switch inputs on PB0/PB1), and OCR0A writes take
+    // effect immediately in normal mode, so the compare match can time delay_usec_idle().
+    TCCR0A = 0;
     TCCR0B = (TIMER0_PRESCALER << CS00);
 
     // Enable the Timer0 overflow interrupt (this is the basic system tic-toc for millis)
@@ -84,29 +112,57 @@ static void timer0_init()
 
 }
 
-// Timer0 overflow interrupt
-ISR(TIMER0_OVF_vect)
+// Move the whole msec in *pf (less than 64) to *pm. One compare per binary digit, so it takes the same
+// time for any value. A loop of 1000 usec steps takes up to 33 passes tickless, which is too long for the
+// show() ISR window and for millis() at 1 MHz.
+static inline void timer0_carry_msec(uint32_t* pm, uint16_t* pf)
+{
+    uint16_t step = 32000U;
+    uint8_t ms = 32;
+
+    do
+    {
+        if (*pf >= step)
+        {
+            *pf -= step;
+            *pm += ms;
+        }
+        step >>= 1;
+        ms >>= 1;
+    } while (ms);
+}
+
+// Advance the time by one Timer0 overflow. Interrupts must be disabled.
+static inline void timer0_ovf_service()
 {
     // copy these to local variables so they can be stored in registers
     // (volatile variables must be read from memory on every access)
     uint32_t m = millis_timer_millis;
-    uint8_t f = millis_timer_fract;
+    uint16_t f = millis_timer_fract;
+    uint16_t us = timer0_ovf_usec + timer0_ovf_adjust;
 
-    f += FRACT_INC;
+    timer0_ovf_adjust = 0;
+    micros_timer_usec += us;
 
-    if (f >= FRACT_MAX)
-    {
-        f -= FRACT_MAX;
-        m += MILLIS_INC + 1;
-    }
-    else
-    {
-        m += MILLIS_INC;
-    }
+    // At most 32768 usec per overflow (tickless), so f stays below 64000
+    f += us;
+    timer0_carry_msec(&m, &f);
 
     millis_timer_fract = f;
     millis_timer_millis = m;
-    millis_timer_overflow_count++;
+}
+
+// Timer0 overflow interrupt
+ISR(TIMER0_OVF_vect)
+{
+    timer0_ovf_service();
+}
+
+// Timer0 compare match A, only used to wake from idle sleep in delay_usec_idle() and timer0_wake_at().
+// One-shot, so a deadline armed by timer0_wake_at() does not wake us again on the next lap of the counter.
+ISR(TIMER0_COMPA_vect)
+{
+    cbi(TIMSK, OCIE0A);
 }
 
 uint32_t millis()
@@ -114,16 +170,50 @@ uint32_t millis()
     uint32_t m;
     uint8_t oldSREG = SREG;
 
+#ifdef TIMER0_TICKLESS_EN
+    // The overflows are too far apart to count millis alone, add the time since the last one
+    uint16_t f;
+    uint8_t t;
+
+    cli();
+    t = TCNT0;
+    // Timer0 overflow has occurred, but we haven't handled the interrupt yet. Handle it here.
+    if ((TIFR & _BV(TOV0)) && (t < 255))
+    {
+        timer0_ovf_service();
+        TIFR = _BV(TOV0);
+    }
+    m = millis_timer_millis;
+    // The ticks before a clock change this period were at the old rate. The sum is never negative.
+    f = millis_timer_fract + timer0_ovf_adjust;
+    SREG = oldSREG;
+
+    f += (uint16_t)t << timer0_tick_shift;
+    timer0_carry_msec(&m, &f);
+#else
     // disable interrupts while we read millis_timer_millis or we might get an
     // inconsistent value (e.g. in the middle of a write to millis_timer_millis)
     cli();
     m = millis_timer_millis;
     // Restores interrupt flag
     SREG = oldSREG;
+#endif
 
     return m;
 }
 
+/* Advance millis() and micros() by time that Timer0 did not count, such as a power-down sleep
+   timed by the watchdog. */
+void millis_advance(uint16_t ms)
+{
+    uint8_t oldSREG = SREG;
+
+    cli();
+    millis_timer_millis += ms;
+    micros_timer_usec += ms * 1000UL;
+    SREG = oldSREG;
+}
+
 uint32_t micros()
 {
 
@@ -132,20 +222,20 @@ uint32_t micros()
 
     cli();
 
-    m = millis_timer_overflow_count;
+    // The ticks before a clock change this period were at the old rate
+    m = micros_timer_usec + timer0_ovf_adjust;
     // Get current counter value.
     t = TCNT0;
 
     // Timer0 overflow has occurred, but we haven't handled the interrupt yet.
     if ((TIFR & _BV(TOV0)) && (t < 255))
     {
-        m++;
+        m += timer0_ovf_usec;
     }
 
     SREG = oldSREG;
 
-    // Can we just do it the naive way? If so great!
-    return ((m << 8) + t) * (MICROSECONDS_PER_TIMER0_TICK);
+    return m + ((uint16_t)t << timer0_tick_shift);
 }
 
 static void __empty()
@@ -185,19 +275,32 @@ void delay_usec(uint16_t us)
 
     // for the 8 MHz internal clock
 
-    // for a 1 and 2 microsecond delay, simply return.  the overhead
-    // of the function call takes 14 (16) cycles, which is 2us
-    if (us <= 2) return; //  = 3 cycles, (4 when true)
-
-    // the following loop takes 1/2 of a microsecond (4 cycles)
-    // per iteration, so execute it twice for each microsecond of
-    // delay requested.
-    us <<= 1; //x2 us, = 2 cycles
+    if (clock_sel == CLK_SEL_1MHZ)
+    {
+        // the following loop takes 4 microseconds (4 cycles) per iteration
+        // at 1 MHz. the overhead of the call and this branch is about 24
+        // cycles (24us), so shorter delays simply return.
+        if (us <= 24) return;
 
-    // account for the time taken in the preceding commands.
-    // we just burned 17 (19) cycles above, remove 4, (4*4=16)
-    // us is at least 6 so we can subtract 4
-    us -= 4; // = 2 cycles
+        us = (us >> 2) - 6;
+        if (us == 0) return;
+    }
+    else
+    {
+        // for a 1 and 2 microsecond delay, simply return.  the overhead
+        // of the function call takes 14 (16) cycles, which is 2us
+        if (us <= 2) return; //  = 3 cycles, (4 when true)
+
+        // the following loop takes 1/2 of a microsecond (4 cycles)
+        // per iteration at 8 MHz, so execute it twice for each microsecond of
+        // delay requested (four times at 16 MHz).
+        us <<= delay_usec_shift;
+
+        // account for the time taken in the preceding commands.
+        // we just burned 17 (19) cycles above, remove 4, (4*4=16)
+        // us is at least 6 so we can subtract 4
+        us -= 4; // = 2 cycles
+    }
 
 
     // busy wait
@@ -211,8 +314,168 @@ void delay_usec(uint16_t us)
 }
 
 
+/* Delay for the given number of microseconds in idle sleep, woken by a Timer0 compare match.
+   Resolution is one Timer0 tick (8 usec at 8 MHz), rounded up. Max 255 ticks. Sets the sleep mode to idle.
+   Falls back to delay_usec() for very short delays or if interrupts are disabled. */
+void delay_usec_idle(uint16_t us)
+{
+    uint8_t ticks, start, oldSREG = SREG;
+
+    if ((us < (2U << timer0_tick_shift)) || !(oldSREG & _BV(SREG_I)))
+    {
+        delay_usec(us);
+        return;
+    }
+    if (us > (255U << timer0_tick_shift))
+    {
+        us = 255U << timer0_tick_shift;
+    }
+    ticks = (us + (1U << timer0_tick_shift) - 1) >> timer0_tick_shift;
+
+    cli();
+
+    start = TCNT0;
+    OCR0A = start + ticks;
+    TIFR = _BV(OCF0A);                  // Clear a stale match (write 1)
+    sbi(TIMSK, OCIE0A);
+
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_enable();
+
+    // The Timer0 overflow can also wake us, so check the elapsed ticks
+    while ((uint8_t)(TCNT0 - start) < ticks)
+    {
+        sei();
+        sleep_cpu();                    // sei() holds off interrupts for one instruction, so no wake-up is missed
+        cli();
+    }
+
+    sleep_disable();
+    cbi(TIMSK, OCIE0A);
+
+    SREG = oldSREG;
+}
+
+/* Arm the Timer0 compare match to wake idle sleep at a millis() deadline, if it comes before the next
+   overflow. Later deadlines are left to the overflow, call again after it. Resolution is one Timer0 tick,
+   the wake-up can be up to 1 msec early. */
+void timer0_wake_at(uint16_t u16_msec)
+{
+    uint8_t t, oldSREG = SREG;
+    int16_t i16_remain = (int16_t)(u16_msec - (uint16_t)millis());
+    uint16_t u16_ticks;
+
+    // Due, or further away than any overflow period (max 32.8 msec)
+    if ((i16_remain <= 0) || (i16_remain > 64)) { return; }
+
+    u16_ticks = ((uint16_t)i16_remain * 1000U) >> timer0_tick_shift;
+
+    cli();
+
+    t = TCNT0;
+    if (u16_ticks < (uint16_t)(255 - t))
+    {
+        OCR0A = t + (uint8_t)u16_ticks + 1;
+        TIFR = _BV(OCF0A);              // Clear a stale match (write 1)
+        sbi(TIMSK, OCIE0A);
+    }
+
+    SREG = oldSREG;
+}
+
+
+/* Switch the system clock, keeping millis(), micros(), the delays and the ADC clock correct.
+   CLK_SEL_16MHZ needs CLK_PLL_EN (PLL clock fuses), and the caller must check Vcc first, see
+   CLK_16MHZ_MIN_MV. Don't call during an ADC conversion. Returns false if the clock is not available. */
+bool clock_set(uint8_t u8_clkSel)
+{
+    uint8_t u8_div, u8_tickShift, u8_delayShift, u8_timerPresc, u8_adcPresc, oldSREG = SREG;
+
+    if (u8_clkSel == clock_sel)
+    {
+        return true;
+    }
+
+    switch (u8_clkSel)
+    {
+    case CLK_SEL_1MHZ:
+#ifdef CLK_PLL_EN
+        u8_div = CLKPR_DIV_16;
+#else
+        u8_div = CLKPR_DIV_8;
+#endif
+        u8_tickShift = TIMER0_TICK_SHIFT_1MHZ;
+        u8_delayShift = 0;              // Not used, delay_usec() has its own 1 MHz loop
+        u8_timerPresc = TIMER0_PRESCALER_1MHZ;
+        u8_adcPresc = ADC_CLK_PRESCALER_1MHZ;
+        break;
+    case CLK_SEL_8MHZ:
+#ifdef CLK_PLL_EN
+        u8_div = CLKPR_DIV_2;
+#else
+        u8_div = CLKPR_DIV_1;
+#endif
+        u8_tickShift = TIMER0_TICK_SHIFT;
+        u8_delayShift = DELAY_USEC_SHIFT;
+        u8_timerPresc = TIMER0_PRESCALER;
+        u8_adcPresc = ADC_CLK_PRESCALER;
+        break;
+#ifdef CLK_PLL_EN
+    case CLK_SEL_16MHZ:
+        u8_div = CLKPR_DIV_1;
+        u8_tickShift = TIMER0_TICK_SHIFT - 1;
+        u8_delayShift = DELAY_USEC_SHIFT + 1;
+        u8_timerPresc = TIMER0_PRESCALER;
+        u8_adcPresc = ADC_CLK_PRESCALER_16MHZ;
+        break;
+#endif
+    default:
+        return false;
+    }
+
+    cli();
+
+    // Account for a pending overflow at the old rate
+    if (TIFR & _BV(TOV0))
+    {
+        timer0_ovf_service();
+        TIFR = _BV(TOV0);
+    }
+
+    // The ticks so far in this overflow period were at the old rate. Correct the next overflow for them.
+    uint8_t t = TCNT0;
+    timer0_ovf_adjust += ((int16_t)t << timer0_tick_shift) - ((int16_t)t << u8_tickShift);
+
+    // Timed sequence, the new value must be written within 4 cycles
+    CLKPR = _BV(CLKPCE);
+    CLKPR = u8_div;
+    TCCR0B = (u8_timerPresc << CS00);
+    adc_set_prescaler(u8_adcPresc);
+
+    clock_sel = u8_clkSel;
+    timer0_tick_shift = u8_tickShift;
+    timer0_ovf_usec = 256U << u8_tickShift;
+    delay_usec_shift = u8_delayShift;
+
+    SREG = oldSREG;
+
+    return true;
+}
+
+uint8_t clock_get()
+{
+    return clock_sel;
+}
+
+
 void init(void)
 {
+#ifdef CLK_PLL_EN
+    // The PLL clock runs at 16 MHz, divide it down to F_CPU
+    CLKPR = _BV(CLKPCE);
+    CLKPR = CLKPR_DIV_2;
+#endif
+
     timer0_init();
     adc_init();
 
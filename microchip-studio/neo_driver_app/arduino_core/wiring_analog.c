@@ -40,6 +40,13 @@ void adc_init()
 
 }
 
+// Set the ADC clock prescaler (ADPS bits), keeping the ADC clock at 125 KHz when the system clock changes.
+// ADIF is left alone, writing it back as 1 would clear it.
+void adc_set_prescaler(uint8_t u8_adps)
+{
+    ADCSRA = (ADCSRA & ~(_BV(ADIF) | (ADC_CLK_PRESCALER_MASK << ADPS0))) | ((u8_adps & ADC_CLK_PRESCALER_MASK) << ADPS0);
+}
+
 // Pass in the channel (ADMUX_MUX selection) and reference (ADMUX_REFS selection)
 uint16_t adc_read(uint8_t ch, uint8_t analog_reference)
 {
@@ -18,6 +18,12 @@ extern "C" {
 // These prescaler bits correspond to "divide by 64"
 //----> 8 MHz (Sys Clk) / 64 = 125 KHz (ADC Clk)
 #define ADC_CLK_PRESCALER   (0b110)
+// Same ADC clock at the other system clocks, see clock_set()
+//----> 1 MHz / 8 = 125 KHz
+#define ADC_CLK_PRESCALER_1MHZ   (0b011)
+//----> 16 MHz / 128 = 125 KHz
+#define ADC_CLK_PRESCALER_16MHZ  (0b111)
+#define ADC_CLK_PRESCALER_MASK   (0b111)
 
 #define ADC_NUM_BITS            (10)
 #define ADC_MAX_VALUE           ((1 << ADC_NUM_BITS) - 1)
@@ -72,6 +78,7 @@ extern "C" {
 /****************************** PROTOTYPES ******************************/
 void adc_init();
 uint16_t adc_read(uint8_t ch, uint8_t analog_reference);
+void adc_set_prescaler(uint8_t u8_adps);
 
 #ifdef __cplusplus
 } // extern "C"
@@ -21,6 +21,8 @@ extern "C"{
 // #define DEBUG_ADC_VAL_EN
 // #define DEBUG_RAND_SEED_EN
 // #define DEBUG_BRIGHT_EN
+// #define DEBUG_COLOR_MATH_BENCH_EN
+// #define DEBUG_MILLIS_DRIFT_EN         // Needs TIMER0_TICKLESS_EN undefined, see debug_millis_drift()
 
 // #define DEBUG_SOFT_RESET_ON_INTERVAL_EN
 #define DEBUG_SOFT_RESET_INTERVAL_SEC   (2)
@@ -9,11 +9,73 @@
 #include <neo_pixel_slim.h>
 #include <neo_common.h>
 #include <avr/eeprom.h>
+#include <avr/pgmspace.h>
 #include <eep_data.h>
 #include <utility.h>
 
 /****************************** STATIC PROTOTYPES ******************************/
-static uint8_t eep_char_read_line(char c_char, uint8_t line);
+static DRAW_BB_T glyph_decode(char c_char);
+#ifdef DRAW_FONT_PROP_EN
+static uint8_t glyph_meta(char c_char);
+#endif
+
+/******************************* FLASH CONSTANTS *******************************/
+// Columns 0..k-1 of every row, k = 0..5. Masks off what an X shift moves across a row boundary.
+static const uint32_t au32_bbColsBelow[] PROGMEM = {
+    0x0000000, 0x0108421, 0x0318C63, 0x0739CE7, 0x0F7BDEF, 0x1FFFFFF
+};
+
+/******************************* STATIC VARIABLES ******************************/
+// Pixel index of each (row,col), row-major, for the orientation set by draw_init()
+static uint8_t au8_pixIndex[MATRIX_NUM_PIX];
+
+#ifdef DRAW_GLYPH_CACHE_EN
+// Decoded glyphs, filled round robin. A key of 0 (outside the char set) marks an empty entry.
+static char      ac_glyphKey[DRAW_GLYPH_CACHE_SIZE];
+static DRAW_BB_T au32_glyphBb[DRAW_GLYPH_CACHE_SIZE];
+static uint8_t u8_glyphNext = 0;
+static uint32_t u32_glyphHits = 0;
+static uint32_t u32_glyphMisses = 0;
+#endif
+
+/*!
+ @brief   Build the (row,col) -> pixel index table for the matrix orientation stored in EEPROM
+          (EEP_SETT_ROT, ANIM_ROT_SEL values). Call once at startup, before drawing characters.
+*/
+void draw_init() {
+    uint8_t u8_rot = eeprom_read_byte(EEP_SETT_ROT);
+    uint8_t u8_idx = 0;
+
+    if ((u8_rot < 1) || (u8_rot > 4)) { u8_rot = ANIM_ROT_SEL; }
+
+    for (uint8_t u8_row = 0; u8_row < 5; u8_row++) {      // Row 0..4, top to bottom
+        for (uint8_t u8_col = 0; u8_col < 5; u8_col++) {  // Col 0..4, right to left
+            uint8_t u8_pixIndex;
+
+            // Calculate pixel index from (row,col)
+            switch (u8_rot) {
+            case 1:
+                if (u8_col % 2 == 0) { u8_pixIndex = u8_col*5     + 4-u8_row; }
+                else                 { u8_pixIndex = u8_col*5     +   u8_row; }
+                break;
+            case 2:
+                if (u8_row % 2 == 0) { u8_pixIndex = (4-u8_row)*5 + 4-u8_col; }
+                else                 { u8_pixIndex = (4-u8_row)*5 +   u8_col; }
+                break;
+            case 3:
+                if (u8_col % 2 == 0) { u8_pixIndex = (4-u8_col)*5 +   u8_row; }
+                else                 { u8_pixIndex = (4-u8_col)*5 + 4-u8_row; }
+                break;
+            default:
+                if (u8_row % 2 == 0) { u8_pixIndex = u8_row*5     +   u8_col; }
+                else                 { u8_pixIndex = u8_row*5     + 4-u8_col; }
+                break;
+            }
+
+            au8_pixIndex[u8_idx++] = u8_pixIndex;
+        }
+    }
+}
 
 // Display an integer value (0-maxVal) on the LEDs
 void draw_value(uint32_t u32_val, uint32_t u32_maxVal) {
@@ -51,76 +113,217 @@ void draw_value_binary(uint32_t u32_val) {
  @param i8_y       Y shift to perform. +Y is down, -Y is up. Y <= -5 or Y >= 5 is out of frame.
 */
 void draw_char(char c_char, uint32_t u32_color, int8_t i8_x, int8_t i8_y) {
+    uint32_t u32_mask = draw_char_mask(c_char, i8_x, i8_y);
+
+    for (uint8_t u8_pixIndex = 0; u8_pixIndex < MATRIX_NUM_PIX; u8_pixIndex++) {
+        if (u32_mask & 0x01) {
+            np_set_pix_color_pack(u8_pixIndex, u32_color);
+        }
+
+        u32_mask >>= 1;
+    }
+}
+
+/*!
+ @brief            Render an ASCII character to a pixel mask, for np_set_mono(). Masks of several
+                   characters can be OR'd together. Same orientation and shift as draw_char().
+ @param c_char     ASCII character to render.
+ @param i8_x       X shift to perform. +X is right, -X is left. X <= -5 or X >= 5 is out of frame.
+ @param i8_y       Y shift to perform. +Y is down, -Y is up. Y <= -5 or Y >= 5 is out of frame.
+ @return           Lit pixels, bit 0 = pixel 0. 0 for characters outside the char set.
+*/
+uint32_t draw_char_mask(char c_char, int8_t i8_x, int8_t i8_y) {
+
+    return draw_bb_to_mask(draw_bb_shift(draw_char_bb(c_char), i8_x, i8_y));
+}
+
+/*!
+ @brief            Get an ASCII character as a bitboard, unshifted.
+ @param c_char     ASCII character.
+ @return           Character bitboard. 0 for characters outside the char set.
+*/
+DRAW_BB_T draw_char_bb(char c_char) {
 
     // Enforce bounds of our ASCII char set
     if ((c_char < ASCII_START) || (c_char > ASCII_START + ASCII_NUM_CHARS - 1)) {
-        return;
+        return 0;
+    }
+
+#ifdef DRAW_GLYPH_CACHE_EN
+    uint8_t u8_entry;
+
+    for (u8_entry = 0; u8_entry < DRAW_GLYPH_CACHE_SIZE; u8_entry++) {
+        if (ac_glyphKey[u8_entry] == c_char) { break; }
     }
 
-    uint8_t au8_buffer[5]; // 5x5 framebuffer
+    if (u8_entry < DRAW_GLYPH_CACHE_SIZE) {
+        u32_glyphHits++;
+    } else {
+        u32_glyphMisses++;
 
-    // Copy char data from EEPROM into framebuffer & perform X shift
-    for (uint8_t u8_i = 0; u8_i < 5; u8_i++) {
-        au8_buffer[u8_i] = eep_char_read_line(c_char, u8_i);
+        u8_entry = u8_glyphNext;
+        if (++u8_glyphNext == DRAW_GLYPH_CACHE_SIZE) { u8_glyphNext = 0; }
 
-        if      (i8_x < 0) { au8_buffer[u8_i] <<= -i8_x; }   // Shift left
-        else if (i8_x > 0) { au8_buffer[u8_i] >>=  i8_x; }   // Shift right
+        au32_glyphBb[u8_entry] = glyph_decode(c_char);
+        ac_glyphKey[u8_entry] = c_char;
     }
 
-    // Perform Y shift
-    if (i8_y != 0) {
-        bool shiftDir = true;                                    // True = Down, False = Up
-        if (i8_y < 0) { shiftDir = false; i8_y = -i8_y; }        // Make y positive
-
-        for (uint8_t u8_shift = 0; u8_shift < i8_y; u8_shift++)  // Perform y # of shifts
-        {
-            // Shift down
-            if (shiftDir) {
-                for (int8_t i8_i = 4; i8_i > 0; i8_i--) {        // i = 4..1
-                    au8_buffer[i8_i] = au8_buffer[i8_i - 1];
-                }
-                au8_buffer[0] = 0;
-
-            // Shift up
-            } else {
-                for (uint8_t u8_i = 0; u8_i < 4; u8_i++) {       // i = 0..3
-                    au8_buffer[u8_i] = au8_buffer[u8_i + 1];
-                }
-                au8_buffer[4] = 0;
-            }
+    return au32_glyphBb[u8_entry];
+#else
+    return glyph_decode(c_char);
+#endif
+}
+
+/*!
+ @brief            Shift a bitboard. Bits shifted out of frame are lost, nothing wraps.
+ @param bb         Bitboard to shift.
+ @param i8_x       X shift to perform. +X is right, -X is left. X <= -5 or X >= 5 is out of frame.
+ @param i8_y       Y shift to perform. +Y is down, -Y is up. Y <= -5 or Y >= 5 is out of frame.
+ @return           Shifted bitboard.
+*/
+DRAW_BB_T draw_bb_shift(DRAW_BB_T bb, int8_t i8_x, int8_t i8_y) {
+
+    if ((i8_x <= -MATRIX_WIDTH_PIX) || (i8_x >= MATRIX_WIDTH_PIX) ||
+        (i8_y <= -MATRIX_HEIGHT_PIX) || (i8_y >= MATRIX_HEIGHT_PIX)) { return 0; }
+
+    // Right is toward col 0, the low bits of each row. Mask what crosses into the neighbouring row.
+    if      (i8_x > 0) { bb = (bb >>  i8_x) &  pgm_read_dword(&au32_bbColsBelow[MATRIX_WIDTH_PIX - i8_x]); }
+    else if (i8_x < 0) { bb = (bb << -i8_x) & ~pgm_read_dword(&au32_bbColsBelow[-i8_x]) & DRAW_BB_ALL; }
+
+    // Down is toward row 4, the high bits. Whole rows, so only the bottom edge needs masking.
+    if      (i8_y > 0) { bb <<= (uint8_t)(i8_y * MATRIX_WIDTH_PIX); }
+    else if (i8_y < 0) { bb >>= (uint8_t)(-i8_y * MATRIX_WIDTH_PIX); }
+
+    return bb & DRAW_BB_ALL;
+}
+
+/*!
+ @brief            Mirror a bitboard left-right.
+*/
+DRAW_BB_T draw_bb_flip_h(DRAW_BB_T bb) {
+
+    return ((bb & DRAW_BB_COL(0)) << 4) | ((bb & DRAW_BB_COL(4)) >> 4) |
+           ((bb & DRAW_BB_COL(1)) << 2) | ((bb & DRAW_BB_COL(3)) >> 2) |
+            (bb & DRAW_BB_COL(2));
+}
+
+/*!
+ @brief            Mirror a bitboard top-bottom.
+*/
+DRAW_BB_T draw_bb_flip_v(DRAW_BB_T bb) {
+
+    return ((bb & DRAW_BB_ROW(0)) << 20) | ((bb & DRAW_BB_ROW(4)) >> 20) |
+           ((bb & DRAW_BB_ROW(1)) << 10) | ((bb & DRAW_BB_ROW(3)) >> 10) |
+            (bb & DRAW_BB_ROW(2));
+}
+
+/*!
+ @brief            Transpose a bitboard, (row,col) -> (col,row). Four delta swaps, one per diagonal
+                   distance k: the bits with col - row = k trade places with their mirror image, 4 * k
+                   bits above.
+*/
+DRAW_BB_T draw_bb_transpose(DRAW_BB_T bb) {
+    DRAW_BB_T t;
+
+    t = ((bb >>  4) ^ bb) & 0x0082082UL;  bb ^= t | (t <<  4);
+    t = ((bb >>  8) ^ bb) & 0x0004104UL;  bb ^= t | (t <<  8);
+    t = ((bb >> 12) ^ bb) & 0x0000208UL;  bb ^= t | (t << 12);
+    t = ((bb >> 16) ^ bb) & 0x0000010UL;  bb ^= t | (t << 16);
+
+    return bb;
+}
+
+/*!
+ @brief            Rotate a bitboard 90 degrees clockwise, as seen on the matrix.
+*/
+DRAW_BB_T draw_bb_rotate_cw(DRAW_BB_T bb) {
+
+    return draw_bb_flip_v(draw_bb_transpose(bb));
+}
+
+/*!
+ @brief            Rotate a bitboard 90 degrees counter-clockwise, as seen on the matrix.
+*/
+DRAW_BB_T draw_bb_rotate_ccw(DRAW_BB_T bb) {
+
+    return draw_bb_transpose(draw_bb_flip_v(bb));
+}
+
+/*!
+ @brief            Blit a bitboard to a pixel mask, for np_set_mono(), through the orientation table.
+ @param bb         Bitboard to render.
+ @return           Lit pixels, bit 0 = pixel 0.
+*/
+uint32_t draw_bb_to_mask(DRAW_BB_T bb) {
+    uint32_t u32_mask = 0;
+    const uint8_t* pu8_pixIndex = au8_pixIndex;
+
+    // Bit (row * 5 + col), row-major like the table. Stop at the last lit bit.
+    while (bb) {
+        if (bb & 0x01) {
+            u32_mask |= (1UL << *pu8_pixIndex);
         }
+
+        pu8_pixIndex++;
+        bb >>= 1;
     }
 
-    // Render the framebuffer
-    for (uint8_t u8_row = 0; u8_row < 5; u8_row++) {      // Row 0..4, top to bottom
-        uint8_t u8_line = au8_buffer[u8_row];             // Get line data from buffer
+    return u32_mask;
+}
 
-        for (uint8_t u8_col = 0; u8_col < 5; u8_col++) {  // Col 0..4, right to left
-            uint8_t u8_pixIndex;
+/*!
+ @brief            Start scrolling a message through the matrix, from a blank screen. The message
+                   can be any length. Chars outside the char set scroll by as blanks.
+ @param pst_s      Scroller state.
+ @param pu8_msg    Null-terminated message.
+ @param b_eep      true: pu8_msg is an EEPROM address. false: it is in flash.
+*/
+void draw_scroll_start(DRAW_SCROLL_T* pst_s, const uint8_t* pu8_msg, bool b_eep) {
+    pst_s->pu8_msg = pu8_msg;
+    pst_s->b_eep = b_eep;
+    pst_s->u16_pos = 0;
+    pst_s->bb_window = 0;
+    pst_s->bb_glyph = 0;
+    pst_s->u8_colsLeft = 0;
+}
 
-            // Calculate pixel index from (row,col)
-            #if   ANIM_ROT_SEL == 1
-                if (u8_col % 2 == 0) { u8_pixIndex = u8_col*5     + 4-u8_row; }
-                else                 { u8_pixIndex = u8_col*5     +   u8_row; }
-            #elif ANIM_ROT_SEL == 2
-                if (u8_row % 2 == 0) { u8_pixIndex = (4-u8_row)*5 + 4-u8_col; }
-                else                 { u8_pixIndex = (4-u8_row)*5 +   u8_col; }
-            #elif ANIM_ROT_SEL == 3
-                if (u8_col % 2 == 0) { u8_pixIndex = (4-u8_col)*5 +   u8_row; }
-                else                 { u8_pixIndex = (4-u8_col)*5 + 4-u8_row; }
-            #elif ANIM_ROT_SEL == 4
-                if (u8_row % 2 == 0) { u8_pixIndex = u8_row*5     +   u8_col; }
-                else                 { u8_pixIndex = u8_row*5     + 4-u8_col; }
-            #endif
+/*!
+ @brief            Scroll the window left by one column, shifting in the next column of the message.
+                   The next glyph is only fetched once the previous one (and its gap) is used up.
+                   Render with draw_bb_to_mask(pst_s->bb_window).
+ @param pst_s      Scroller state.
+ @return           false at the end of the message, when the window was left as is.
+*/
+bool draw_scroll_step(DRAW_SCROLL_T* pst_s) {
 
+    if (pst_s->u8_colsLeft == 0) {
+        const uint8_t* pu8_c = pst_s->pu8_msg + pst_s->u16_pos;
+        char c_next = pst_s->b_eep ? eeprom_read_byte(pu8_c) : pgm_read_byte(pu8_c);
 
-            if (u8_line & 0x01) {
-                np_set_pix_color_pack(u8_pixIndex, u32_color); // Extract bit for (row,col)
-            }
+        if (c_next == 0) { return false; }
 
-            u8_line >>= 1; // Next column
-        }
+        pst_s->u16_pos++;
+        pst_s->bb_glyph = draw_char_bb(c_next);
+
+    #ifdef DRAW_FONT_PROP_EN
+        // Drop the blank columns at the left, and stop after the right-most lit one
+        uint8_t u8_meta = glyph_meta(c_next);
+        uint8_t u8_width = EEP_CHAR_META_WIDTH(u8_meta);
+
+        pst_s->bb_glyph = draw_bb_shift(pst_s->bb_glyph, -EEP_CHAR_META_SKIP(u8_meta), 0);
+        if (u8_width == 0) { u8_width = DRAW_SCROLL_SPACE_COLS; }
+        pst_s->u8_colsLeft = u8_width + DRAW_SCROLL_GAP_COLS;
+    #else
+        pst_s->u8_colsLeft = MATRIX_WIDTH_PIX + DRAW_SCROLL_GAP_COLS;
+    #endif
     }
+
+    // Left-most glyph column (col 4) enters the window at the right (col 0). Once the glyph is used up, this is 0.
+    pst_s->bb_window = draw_bb_shift(pst_s->bb_window, -1, 0) | ((pst_s->bb_glyph & DRAW_BB_COL(4)) >> 4);
+    pst_s->bb_glyph = draw_bb_shift(pst_s->bb_glyph, -1, 0);
+    pst_s->u8_colsLeft--;
+
+    return true;
 }
 
 // Draw a character, centered (no X or Y shift)
@@ -129,29 +332,57 @@ void draw_char_cent(char c_char, uint32_t u32_color)
     draw_char(c_char, u32_color, 0, 0);
 }
 
-// Extract a line of a character from the compressed EEPROM char data
-// line: 0-4, top-bottom
-static uint8_t eep_char_read_line(char c_char, uint8_t line)
+#ifdef DRAW_GLYPH_CACHE_EN
+// Glyph cache statistics, since power on
+uint32_t draw_get_glyph_hit_count()  { return u32_glyphHits; }
+uint32_t draw_get_glyph_miss_count() { return u32_glyphMisses; }
+#endif
+
+// Extract a character from the compressed EEPROM char data, as a bitboard.
+// The 25 bits of a glyph span at most 4 bytes, those are read in one burst.
+static DRAW_BB_T glyph_decode(char c_char)
+{
+    uint16_t bit_start_index = (uint16_t)(c_char - ASCII_START) * MATRIX_NUM_PIX;
+    uint8_t au8_eep[4];
+    uint32_t u32_bits;
+    DRAW_BB_T bb = 0;
+
+    eeprom_read_block(au8_eep, (const void*)(EEP_CHAR_DATA_START_ADDR + (bit_start_index / BITS_IN_BYTE)), sizeof(au8_eep));
+
+    // Big-endian, shifted so the first bit of the glyph (left-most of line 0) is the MSB
+    u32_bits = ((uint32_t)au8_eep[0] << 24) | ((uint32_t)au8_eep[1] << 16) | ((uint16_t)au8_eep[2] << 8) | au8_eep[3];
+    u32_bits <<= (bit_start_index % BITS_IN_BYTE);
+
+    // Lines top-bottom, each entering at row 4 and moving up to row 0 by the end
+    for (uint8_t u8_i = 0; u8_i < MATRIX_HEIGHT_PIX; u8_i++) {
+        bb = (bb >> MATRIX_WIDTH_PIX) | ((u32_bits >> (32 - MATRIX_WIDTH_PIX)) << (MATRIX_NUM_PIX - MATRIX_WIDTH_PIX));
+        u32_bits <<= MATRIX_WIDTH_PIX;
+    }
+
+    return bb;
+}
+
+#ifdef DRAW_FONT_PROP_EN
+// Read the metadata of a character (EEP_CHAR_META_XXX). Chars outside the set, and blank or invalid EEPROM
+// (metadata not written yet), get the full cell: no skip, width 5.
+static uint8_t glyph_meta(char c_char)
 {
-    uint16_t char_index = (c_char - ASCII_START);
-    uint16_t bit_start_index = (char_index * MATRIX_NUM_PIX) + (MATRIX_WIDTH_PIX * line);
-    // Byte index where beginning of line data is found
-    uint16_t byte_start_index = bit_start_index / BITS_IN_BYTE;
+    uint8_t u8_meta = MATRIX_WIDTH_PIX;
 
-    uint8_t* byte_start_addr = (uint8_t*)(EEP_CHAR_DATA_START_ADDR + byte_start_index);
-    // Bit which is the first bit of the line data (left-most)
-    uint16_t bit_within_byte_index = BITS_IN_BYTE - (bit_start_index % BITS_IN_BYTE) - 1;
+    if ((c_char >= ASCII_START) && (c_char <= ASCII_START + ASCII_NUM_CHARS - 1)) {
+        uint16_t bit_start_index = (uint16_t)(c_char - ASCII_START) * EEP_CHAR_META_BITS;
+        uint8_t au8_eep[2];
 
-    // Compose a u16 with first and second bytes, since the line data *may* span two bytes
-    uint16_t u16_eep_read = ((eeprom_read_byte(byte_start_addr) << 8) | eeprom_read_byte(byte_start_addr+1));
-    uint16_t bit_within_word_index = bit_within_byte_index + BITS_IN_BYTE;
+        // 6 bits span at most 2 bytes
+        eeprom_read_block(au8_eep, (const void*)(EEP_CHAR_META_START_ADDR + (bit_start_index / BITS_IN_BYTE)), sizeof(au8_eep));
+        uint8_t u8_read = (((uint16_t)au8_eep[0] << 8 | au8_eep[1]) >> (16 - EEP_CHAR_META_BITS - (bit_start_index % BITS_IN_BYTE))) & 0x3F;
 
-    // Extract the 5-bit line data, place in lower 5-bits of the byte to be returned
-    uint8_t line_data = (u16_eep_read >> (bit_within_word_index - MATRIX_WIDTH_PIX + 1)) & 0x1F;
+        if (EEP_CHAR_META_SKIP(u8_read) + EEP_CHAR_META_WIDTH(u8_read) <= MATRIX_WIDTH_PIX) { u8_meta = u8_read; }
+    }
 
-    return line_data;
-    
+    return u8_meta;
 }
+#endif
 
 // Extract base data from sequence table stored in EEPROM
 uint8_t read_cov_base(uint16_t u16_baseNum) {
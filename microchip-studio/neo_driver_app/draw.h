@@ -7,6 +7,7 @@
 #define DRAW_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 // Allow compilation with C++ compiler
 #ifdef __cplusplus
@@ -18,6 +19,8 @@ extern "C"{
 /*
  *   ANIM_ROT_SEL - Rotation select for 5x5 Matrix - Increasing #, Turning clockwise
  *   Used by the draw_char() function to correctly orient the characters.
+ *   The orientation is read from EEP_SETT_ROT at startup (draw_init()), this is the value eep_data_write stores
+ *   there, and the fallback for a blank setting.
  *
  *   Value |  Input wires located at:
  *   ================================
@@ -28,6 +31,11 @@ extern "C"{
  */
 #define ANIM_ROT_SEL 3
 
+// Keep decoded glyphs in SRAM, so text drawn every frame doesn't go back to EEPROM. 4 bytes (DRAW_BB_T) + 1 byte key per entry.
+// A scrolling message shows 2 glyphs at a time.
+#define DRAW_GLYPH_CACHE_EN
+#define DRAW_GLYPH_CACHE_SIZE   (4)
+
 #define BATT_ICON_LVL_1     '#'
 #define BATT_ICON_LVL_2     '$'
 #define BATT_ICON_LVL_3     '%'
@@ -46,12 +54,55 @@ extern "C"{
 
 #define COLOR_WHEEL  0x000000UL // Dynamic color wheel effect
 
+// 5x5 bitboard. Bit (row * 5 + col): row 0 at the top, col 0 at the right, like a glyph line (LSB first).
+// Bits 25-31 stay 0. Boards compose with the plain operators: | union, ^ toggle, & ~ erase.
+#define DRAW_BB_ALL     (0x1FFFFFFUL)
+#define DRAW_BB_ROW(r)  (0x000001FUL << (5 * (r)))
+#define DRAW_BB_COL(c)  (0x0108421UL << (c))
+
+#define DRAW_SCROLL_GAP_COLS  (1)   // Blank columns after each glyph
+
+// Scroll each glyph by its own width (EEP_CHAR_META_START_ADDR metadata), instead of a fixed 5 column cell.
+// Blank glyphs (space) take DRAW_SCROLL_SPACE_COLS. Without the metadata in EEPROM, glyphs use the full cell.
+#define DRAW_FONT_PROP_EN
+#define DRAW_SCROLL_SPACE_COLS  (2)
+
+/*********************************** TYPEDEFS ***********************************/
+typedef uint32_t DRAW_BB_T;
+
+/*********************************** STRUCTS ************************************/
+// Text scroller state, see draw_scroll_start()
+typedef struct {
+    const uint8_t* pu8_msg;       // Null-terminated message, in flash or EEPROM
+    bool     b_eep;               // Message is in EEPROM, else in flash
+    uint16_t u16_pos;             // Index of the next char in the message
+    DRAW_BB_T bb_window;          // On screen. New columns enter at the right.
+    DRAW_BB_T bb_glyph;           // Columns of the current glyph not shifted in yet, next at the left
+    uint8_t  u8_colsLeft;         // Columns of the current glyph cell still to shift in, including the gap
+} DRAW_SCROLL_T;
+
 /********************************** PROTOTYPES **********************************/
 // Drawing functions
+void draw_init();
 void draw_char(char c_char, uint32_t u32_color, int8_t i8_x, int8_t i8_y);
 void draw_char_cent(char c_char, uint32_t u32_color);
+uint32_t draw_char_mask(char c_char, int8_t i8_x, int8_t i8_y);
+DRAW_BB_T draw_char_bb(char c_char);
+DRAW_BB_T draw_bb_shift(DRAW_BB_T bb, int8_t i8_x, int8_t i8_y);
+DRAW_BB_T draw_bb_flip_h(DRAW_BB_T bb);
+DRAW_BB_T draw_bb_flip_v(DRAW_BB_T bb);
+DRAW_BB_T draw_bb_transpose(DRAW_BB_T bb);
+DRAW_BB_T draw_bb_rotate_cw(DRAW_BB_T bb);
+DRAW_BB_T draw_bb_rotate_ccw(DRAW_BB_T bb);
+uint32_t draw_bb_to_mask(DRAW_BB_T bb);
+void draw_scroll_start(DRAW_SCROLL_T* pst_s, const uint8_t* pu8_msg, bool b_eep);
+bool draw_scroll_step(DRAW_SCROLL_T* pst_s);
 void draw_value(uint32_t u32_val, uint32_t u32_maxVal);
 void draw_value_binary(uint32_t u32_val);
+#ifdef DRAW_GLYPH_CACHE_EN
+uint32_t draw_get_glyph_hit_count();
+uint32_t draw_get_glyph_miss_count();
+#endif
 
 // Drawing "support" functions
 uint8_t read_cov_base(uint16_t u16_baseNum);
@@ -5,8 +5,10 @@
 
 /*  
     EEPROM MEMORY MAP (512B total):
-    0-6:     (7B)   Settings Data
-    7-431:   (425B) Character Data (85 chars) (ASCII 32-116)
+    0-15:    (16B)  Settings Data (15: Matrix orientation)
+    16-290:  (275B) Character Data (88 chars) (ASCII 32-119)
+    291-356: (66B)  Glyph Metadata (88 x 6 bits)
+    357-431: (75B)  Free
     432-511: (80B)  SARS-CoV-2 Sequence Data (320 bases)
 */
 
@@ -25,6 +27,7 @@
 
 /******************************** PROTOTYPES *********************************/
 static bool eep_compressed_chars(bool validate);
+static bool eep_char_meta(bool validate);
 
 /********************************** DEFINES **********************************/
 
@@ -48,6 +51,8 @@ void setup() {
 
     // Update EEPROM Data
     eep_compressed_chars(false);
+    eep_char_meta(false);
+    eeprom_update_byte(EEP_SETT_ROT, ANIM_ROT_SEL);
 
     #ifdef EEP_COV_DATA_WRITE_ENABLE
     for (uint16_t i = 0; i < EEP_COV_DATA_NUM_BYTES; i++) {
@@ -58,6 +63,8 @@ void setup() {
     // Verify EEPROM Data
     bool dataOK = true;
     if (!eep_compressed_chars(true)) { dataOK = false; }
+    if (!eep_char_meta(true)) { dataOK = false; }
+    if (eeprom_read_byte(EEP_SETT_ROT) != ANIM_ROT_SEL) { dataOK = false; }
 
     #ifdef EEP_COV_DATA_WRITE_ENABLE
     for (uint16_t i = 0; i < EEP_COV_DATA_NUM_BYTES; i++) {
@@ -163,4 +170,68 @@ static bool eep_compressed_chars(bool validate)
     return dataOK;
 }
 
+/*
+    Glyph metadata (see EEP_CHAR_META_START_ADDR), derived from the lit columns of each glyph in charSet.
+    validate = false -> "Update" EEPROM with correct values, possibly performing writes
+    validate = true  -> Check EEPROM for correct values, performing no writes, returning status
+*/
+static bool eep_char_meta(bool validate)
+{
+    uint8_t* eep_addr = (uint8_t*)(EEP_CHAR_META_START_ADDR);
+    uint16_t acc = 0;           // Bits not yet written, in the lower acc_bits
+    uint8_t acc_bits = 0;
+    uint8_t output_byte;
+    bool dataOK = true;
+
+    for (uint8_t glyph = 0; glyph <= EEP_CHAR_DATA_NUM_CHARS; glyph++)
+    {
+        if (glyph < EEP_CHAR_DATA_NUM_CHARS)
+        {
+            // Columns lit in any line, bit 4 = left-most
+            uint8_t cols = 0;
+            for (uint8_t line = 0; line < MATRIX_HEIGHT_PIX; line++)
+            {
+                cols |= pgm_read_byte(&charSet[glyph * MATRIX_HEIGHT_PIX + line]);
+            }
+
+            uint8_t skip = 0;
+            uint8_t width = 0;
+            if (cols)
+            {
+                while (!(cols & (1 << (MATRIX_WIDTH_PIX - 1 - skip)))) { skip++; }
+                width = MATRIX_WIDTH_PIX - skip;
+                while (!(cols & 0x01)) { cols >>= 1; width--; }
+            }
+
+            acc = (acc << EEP_CHAR_META_BITS) | (skip << 3) | width;
+            acc_bits += EEP_CHAR_META_BITS;
+        }
+        else if (acc_bits)
+        {
+            // Pad the last byte with zeros
+            acc <<= (8 - acc_bits);
+            acc_bits = 8;
+        }
+
+        // Flush whole output bytes
+        while (acc_bits >= 8)
+        {
+            acc_bits -= 8;
+            output_byte = (uint8_t)(acc >> acc_bits);
+
+            if (validate)
+            {
+                if (eeprom_read_byte(eep_addr) != output_byte) { dataOK = false; }
+            }
+            else
+            {
+                eeprom_update_byte(eep_addr, output_byte);
+            }
+            eep_addr++;
+        }
+    }
+
+    return dataOK;
+}
+
 #endif
\ No newline at end of file
@@ -19,7 +19,7 @@
 // First 16 bytes reserved for settings storage
 #define EEP_SETT_FIRST_ADDR     (0)
 #define EEP_SETT_ANIM           ((uint8_t*)(0))    // No longer used, since we are picking a random animation at startup
-#define EEP_SETT_NPIX           ((uint8_t*)(1))    // No longer needed, since we are using a fixed 5x5 matrix
+#define EEP_SETT_NPIX           ((uint8_t*)(1))    // Number of pixels, set in pixel adjust mode. Out of range (blank) = NP_PIXEL_COUNT_MAX
 #define EEP_SETT_RSEED          ((uint32_t*)(2))   // Addr 2-5, 4 bytes
 #define EEP_SETT_FLAGS          ((uint8_t*)(6))    // 8 Status Flags
 // Runtime since last charge in minutes. Includes "on" and "off" time. Stops counting once battery is "dead".
@@ -28,6 +28,10 @@
 #define EEP_SETT_NUM_CYCLES     ((uint16_t*)(9))   // 2 bytes
 // Number of power-on's since stat reset.
 #define EEP_SETT_NUM_POWER_ON   ((uint16_t*)(11))  // 2 bytes
+// Measured watchdog period, usec per nominal 16 msec. Out of range (blank) = WDT_CAL_NOMINAL_USEC
+#define EEP_SETT_WDT_CAL        ((uint16_t*)(13))  // 2 bytes
+// Matrix orientation (ANIM_ROT_SEL values), written by eep_data_write. Out of range (blank) = ANIM_ROT_SEL
+#define EEP_SETT_ROT            ((uint8_t*)(15))
 #define EEP_SETT_LAST_ADDR      (15)
 
 // Status Flags (bits in EEP_SETT_FLAGS)
@@ -57,6 +61,7 @@
 
     25 bits per glyph
     With compression, we have space for up to 158 glyphs, if cov animation not used.
+    The 6 bit glyph metadata follows, 31 bits per glyph in all: up to 107 glyphs before the cov data.
 */
 static const uint8_t PROGMEM charSet[] = {
     // [ASCII: CHAR]
@@ -785,6 +790,19 @@ static const uint8_t PROGMEM charSet[] = {
 #define ASCII_START (32)
 #define ASCII_NUM_CHARS (EEP_CHAR_DATA_NUM_CHARS)
 
+/*
+    Glyph metadata, for proportional text. Follows the char data (EEPROM 291-356 for 88 glyphs).
+    6 bits per glyph, packed MSB first like the char data:
+      bits 5-3: Blank columns at the left of the glyph (0-4)
+      bits 2-0: Width, left-most to right-most lit column (1-5). 0 for a blank glyph.
+    Derived from charSet by eep_data_write.
+*/
+#define EEP_CHAR_META_START_ADDR  (EEP_CHAR_DATA_START_ADDR + EEP_CHAR_DATA_NUM_BYTES)
+#define EEP_CHAR_META_BITS        (6)
+#define EEP_CHAR_META_NUM_BYTES   (DIV_CEILING((EEP_CHAR_DATA_NUM_CHARS * EEP_CHAR_META_BITS), 8))
+#define EEP_CHAR_META_SKIP(m)     ((m) >> 3)
+#define EEP_CHAR_META_WIDTH(m)    ((m) & 0x07)
+
 /* 
     *****************************************************************************
     SARS-CoV-2 Data (80B)
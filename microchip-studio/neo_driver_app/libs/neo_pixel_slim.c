@@ -44,75 +44,105 @@
  */
 
 #include "neo_pixel_slim.h"
+#include "neo_pixel_tables.h"   // Generated by scripts/gen-np-tables.py
 #include <utility.h>
+#include <stddef.h>
 #include <avr/io.h>
 
+/****************************** DEFINES ******************************/
+/* Send one byte, MSB first, with the bit timing for a `mhz` system clock. The wait
+   cycle counts are asm constants, so each use expands to its own kernel. Uses the
+   locals bitctr, curbyte, port, maskhi and masklo of np_show(). */
+#define np_send_byte(mhz)                                                                   \
+    __asm__ volatile(                                                                       \
+    "       ldi   %0,8  \n\t"                                                               \
+    "loop%=:            \n\t"                                                               \
+    "       st    X,%3 \n\t"     /*  '1' [02] '0' [02] - re       */                        \
+    w_nops("%[w1]")                                                                         \
+    "       sbrs  %1,7  \n\t"    /*  '1' [04] '0' [03]            */                        \
+    "       st    X,%4 \n\t"     /*  '1' [--] '0' [05] - fe-low   */                        \
+    "       lsl   %1    \n\t"    /*  '1' [05] '0' [06]            */                        \
+    w_nops("%[w2]")                                                                         \
+    "       brcc skipone%= \n\t" /*  '1' [+1] '0' [+2] -          */                        \
+    "       st   X,%4      \n\t" /*  '1' [+3] '0' [--] - fe-high  */                        \
+    "skipone%=:         \n\t"    /*  '1' [+3] '0' [+2] -          */                        \
+    w_nops("%[w3]")                                                                         \
+    "       dec   %0    \n\t"    /*  '1' [+4] '0' [+3]            */                        \
+    "       brne  loop%=\n\t"    /*  '1' [+5] '0' [+4]            */                        \
+    :   "=&d" (bitctr)                                                                      \
+    :   "r" (curbyte), "x" (port), "r" (maskhi), "r" (masklo),                              \
+        [w1] "n" (w_wait1_cyc(mhz)), [w2] "n" (w_wait2_cyc(mhz)), [w3] "n" (w_wait3_cyc(mhz)) \
+    )
+
 /****************************** STATIC VARS ******************************/
 static uint8_t           u8_brightness = 0; ///< Strip brightness 0-255 (stored as +1)
-static uint16_t          u16_endTime = 0;   ///< Latch timing reference
-
+static uint16_t          u16_endUsec = 0;   ///< Latch timing reference, micros() at the end of the last transmit
+static uint8_t           u8_numPix = NP_PIXEL_COUNT_MAX; ///< Pixels in use
+static uint8_t           u8_txPixCnt = NP_PIXEL_COUNT_MAX; ///< Pixels to send on next show: one past the highest pixel changed since the last transmit
+static uint32_t          u32_showCnt = 0;   ///< Number of frames transmitted
+static uint32_t          u32_skipCnt = 0;   ///< Number of show() calls skipped, pixels already held the same data
+static np_shader_t       pf_shader = NULL;  ///< Shader for the next show(), NULL to send the pixel data in RAM
+static bool              b_monoPending = false; ///< Next show() sends the mono frame below
+static bool              b_monoLatched = false; ///< The pixels hold exactly the mono frame below
+static uint32_t          u32_monoMask;      ///< Mono frame: lit pixels, bit 0 = pixel 0
+static uint32_t          u32_monoColor;     ///< Mono frame: packed RGB of the lit pixels
+static bool              b_powerOn = false; ///< Pixel power rail state, see np_power_on()
+static bool              b_dark = true;     ///< The strip shows an all-black frame
+static uint16_t          u16_level = 0;     ///< Sum of the color bytes on the strip, after scaling. See np_get_level().
+
+#ifdef NP_FB_PALETTE_EN
+static uint8_t au8_pixelIdx[NP_PAL_IDX_ARR_SIZE];                 // 4-bit palette index per pixel, even pixels in the low nibble
+static uint8_t au8_palette[NP_PAL_SIZE * NP_BYTES_PER_PIXEL];     // GRB color data per palette entry. Entry 0 is always black.
+static uint8_t u8_palUsed = 1;                                    // Number of palette entries in use
+#else
 static uint8_t au8_pixelData[NP_ARR_SIZE];  // 3 bytes of GRB color data per pixel
+#endif
+
+/*************************** STATIC PROTOTYPES ***************************/
+static inline uint8_t np_scale_8(uint8_t u8_x, uint8_t u8_scale);
+static inline uint8_t np_scale_8_plus1(uint8_t u8_x, uint8_t u8_scale);
+static void np_set_pix_grb(uint8_t u8_index, uint8_t u8_green, uint8_t u8_red, uint8_t u8_blue);
+static uint16_t np_frame_sum(uint8_t u8_first);
+#ifdef NP_FB_PALETTE_EN
+static uint8_t np_pal_get_idx(uint8_t u8_index);
+static void np_pal_set_idx(uint8_t u8_index, uint8_t u8_palIdx);
+static uint8_t np_pal_find(uint8_t u8_green, uint8_t u8_red, uint8_t u8_blue);
+static inline uint8_t np_abs_diff(uint8_t u8_a, uint8_t u8_b);
+#endif
 
-// These two tables are declared outside the Adafruit_NeoPixel class
-// because some boards may require oldschool compilers that don't
-// handle the C++11 constexpr keyword.
-
-// NOTE: If these are defined in the header file instead, they get placed in flash twice!
-// PROGMEM arrays should be defined in .cpp/.c files!
-
-/* A PROGMEM (flash mem) table containing 8-bit unsigned sine wave (0-255).
-     Copy & paste this snippet into a Python REPL to regenerate:
-import math
-for x in range(256):
-        print("{:3},".format(int((math.sin(x/128.0*math.pi)+1.0)*127.5+0.5))),
-        if x&15 == 15: print
+/*!
+    @brief   Scale an 8-bit value: (x * scale) >> 8. Shift-and-add, since the
+                     ATtiny85 has no hardware multiplier. Constant 32 cycles, short
+                     enough to run in the gap between bytes of a transmit.
 */
-// 16 x 16 table
-static const uint8_t PROGMEM _au8_NeoPixelSineTable[256] = {
-    128,131,134,137,140,143,146,149,152,155,158,162,165,167,170,173,  // 0-15
-    176,179,182,185,188,190,193,196,198,201,203,206,208,211,213,215,  // 16-31
-    218,220,222,224,226,228,230,232,234,235,237,238,240,241,243,244,  // 32-47
-    245,246,248,249,250,250,251,252,253,253,254,254,254,255,255,255,  // 48-63
-    255,255,255,255,254,254,254,253,253,252,251,250,250,249,248,246,  // 64-79
-    245,244,243,241,240,238,237,235,234,232,230,228,226,224,222,220,  // 80-95
-    218,215,213,211,208,206,203,201,198,196,193,190,188,185,182,179,  // 96-111
-    176,173,170,167,165,162,158,155,152,149,146,143,140,137,134,131,  // 112-127
-    128,124,121,118,115,112,109,106,103,100, 97, 93, 90, 88, 85, 82,  // 128-143
-     79, 76, 73, 70, 67, 65, 62, 59, 57, 54, 52, 49, 47, 44, 42, 40,  // 144-159
-     37, 35, 33, 31, 29, 27, 25, 23, 21, 20, 18, 17, 15, 14, 12, 11,  // 160-175
-     10,  9,  7,  6,  5,  5,  4,  3,  2,  2,  1,  1,  1,  0,  0,  0,  // 176-191
-      0,  0,  0,  0,  1,  1,  1,  2,  2,  3,  4,  5,  5,  6,  7,  9,  // 192-207
-     10, 11, 12, 14, 15, 17, 18, 20, 21, 23, 25, 27, 29, 31, 33, 35,  // 208-223
-     37, 40, 42, 44, 47, 49, 52, 54, 57, 59, 62, 65, 67, 70, 73, 76,  // 224-239
-     79, 82, 85, 88, 90, 93, 97,100,103,106,109,112,115,118,121,124   // 240-255
-};
-
-/* Similar to above, but for an 8-bit gamma-correction table.
-     Copy & paste this snippet into a Python REPL to regenerate:
-import math
-gamma=2.6
-for x in range(256):
-        print("{:3},".format(int(math.pow((x)/255.0,gamma)*255.0+0.5))),
-        if x&15 == 15: print
+static inline uint8_t np_scale_8(uint8_t u8_x, uint8_t u8_scale) {
+    uint8_t u8_res = 0;
+
+    // For each bit of the scale, LSB first: add x to the high byte if set, then
+    // shift the (carry:high byte) right. After 8 bits the high byte of x*scale remains.
+    __asm__ (
+        ".rept 8        \n\t"
+        "   lsr  %1     \n\t"
+        "   brcc 1f     \n\t"
+        "   add  %0,%2  \n\t"
+        "1: ror  %0     \n\t"
+        ".endr          \n\t"
+        : "+r" (u8_res), "+r" (u8_scale)
+        : "r" (u8_x)
+    );
+
+    return u8_res;
+}
+
+/*!
+    @brief   Scale an 8-bit value by (scale + 1): (x * (scale + 1)) >> 8.
+                     A scale of 255 returns x unchanged. Same result as the 16-bit
+                     multiply used by the Adafruit library, without the multiply.
 */
-static const uint8_t PROGMEM _au8_NeoPixelGammaTable[256] = {
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  1,  1,  1,  1,  1,  1,  1,  1,
-    1,  1,  1,  1,  2,  2,  2,  2,  2,  2,  2,  2,  3,  3,  3,  3,
-    3,  3,  4,  4,  4,  4,  5,  5,  5,  5,  5,  6,  6,  6,  6,  7,
-    7,  7,  8,  8,  8,  9,  9,  9, 10, 10, 10, 11, 11, 11, 12, 12,
-    13, 13, 13, 14, 14, 15, 15, 16, 16, 17, 17, 18, 18, 19, 19, 20,
-    20, 21, 21, 22, 22, 23, 24, 24, 25, 25, 26, 27, 27, 28, 29, 29,
-    30, 31, 31, 32, 33, 34, 34, 35, 36, 37, 38, 38, 39, 40, 41, 42,
-    42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57,
-    58, 59, 60, 61, 62, 63, 64, 65, 66, 68, 69, 70, 71, 72, 73, 75,
-    76, 77, 78, 80, 81, 82, 84, 85, 86, 88, 89, 90, 92, 93, 94, 96,
-    97, 99,100,102,103,105,106,108,109,111,112,114,115,117,119,120,
-    122,124,125,127,129,130,132,134,136,137,139,141,143,145,146,148,
-    150,152,154,156,158,160,162,164,166,168,170,172,174,176,178,180,
-    182,184,186,188,191,193,195,197,199,202,204,206,209,211,213,215,
-    218,220,223,225,227,230,232,235,237,240,242,245,247,250,252,255
-};
+static inline uint8_t np_scale_8_plus1(uint8_t u8_x, uint8_t u8_scale) {
+    if (u8_scale == 255) { return u8_x; }
+    return np_scale_8(u8_x, u8_scale + 1);
+}
 
 /*!
     @brief   Configure NeoPixel pin for output.
@@ -128,14 +158,10 @@ void np_init(void) {
 
 /*!
     @brief   Transmit pixel data in RAM to NeoPixels.
-    @note    On most architectures, interrupts are temporarily disabled in
-                     order to achieve the correct NeoPixel signal timing. This means
-                     that the Arduino millis() and micros() functions, which require
-                     interrupts, will lose small intervals of time whenever this
-                     function is called (about 30 microseconds per RGB pixel, 40 for
-                     RGBW pixels). There's no easy fix for this, but a few
-                     specialized alternative or companion libraries exist that use
-                     very device-specific peripherals to work around it.
+    @note    Interrupts are disabled while each pixel is sent, in order to
+                     achieve the correct NeoPixel signal timing. With
+                     NP_SHOW_ISR_WINDOW_EN, a pending Timer0 overflow is serviced in
+                     the gap between pixels, so millis() and micros() don't lose time.
 */
 /*
 * light weight WS2812 lib V2.5b
@@ -158,13 +184,40 @@ void np_init(void) {
 */
 void np_show(void) {
 
+    // The pixels already hold this frame, nothing to send
+    if (b_monoPending ? b_monoLatched : ((u8_txPixCnt == 0) && (pf_shader == NULL))) {
+        b_monoPending = false;
+        u32_skipCnt++;
+        return;
+    }
+
+    // The bit timing, the shader budget and the frame sum below need at least F_CPU. Restored on the way out.
+    uint8_t u8_clkPrev = clock_get();
+    if (u8_clkPrev < CLK_SEL_8MHZ) { clock_set(CLK_SEL_8MHZ); }
+
+    // Rail is off (np_power_off()). Keep it off while there is nothing to light. Only then
+    // is the frame summed before it is sent. Shaded frames are unknown until sent.
+    if (!b_powerOn) {
+        if ((pf_shader == NULL) && (np_frame_sum(0) == 0)) {
+            b_monoPending = false;
+            u32_skipCnt++;
+            clock_set(u8_clkPrev);
+            return;
+        }
+        np_power_on();
+    }
+    u32_showCnt++;
+    uint16_t u16_wireSum = 0;
+    uint8_t u8_wireLit = 0;     // OR of the bytes sent, before scaling, see np_is_dark()
+
     // Data latch = 300+ microsecond pause in the output stream. Rather than
     // put a delay at the end of the function, the ending time is noted and
     // the function will simply hold off (if needed) on issuing the
     // subsequent round of data until the latch time has elapsed. This
     // allows the mainline code to start generating the next frame of data
-    // rather than stalling for the latch.
-    while(!np_can_show()) {}
+    // rather than stalling for the latch. Any remainder is slept through.
+    uint16_t u16_latchRem = np_latch_remaining_usec();
+    if (u16_latchRem) { delay_usec_idle(u16_latchRem); }
     // endTime is a private member (rather than global var) so that multiple
     // instances on different pins can be quickly issued in succession (each
     // instance doesn't delay the next).
@@ -182,9 +235,38 @@ void np_show(void) {
     // `maskhi` is 0x80 if P?7 is LED DATA
     uint8_t curbyte, bitctr, masklo, maskhi;
     uint8_t sreg_prev;
+    uint8_t u8_bright = u8_brightness;
+#ifdef NP_FB_PALETTE_EN
+    uint8_t* data;
+#else
     uint8_t* data = au8_pixelData;
-    uint8_t datlen = NP_ARR_SIZE;
+#endif
+    uint8_t au8_shaded[NP_BYTES_PER_PIXEL]; // GRB of the pixel just computed by the shader, or of the lit mono pixels
+    uint8_t au8_unlit[NP_BYTES_PER_PIXEL] = {0, 0, 0};
+    uint32_t u32_mask = u32_monoMask;
+    uint8_t u8_byteCnt;
+    // Only send the prefix up to the last changed pixel. Pixels past the end of a
+    // shorter stream keep their latched color.
+    uint8_t u8_pixCnt = u8_txPixCnt;
+    u8_txPixCnt = 0;
     volatile uint8_t* port = &NP_PORT;
+
+    if ((pf_shader != NULL) || b_monoPending) {
+        u8_pixCnt = np_get_length();
+    }
+
+    if (b_monoPending) {
+        au8_shaded[0] = (uint8_t)(u32_monoColor >>  8);   // GRB transmit order
+        au8_shaded[1] = (uint8_t)(u32_monoColor >> 16);
+        au8_shaded[2] = (uint8_t)(u32_monoColor >>  0);
+    #ifndef NP_SCALE_ON_SHOW_EN
+        if (u8_bright) {
+            au8_shaded[0] = np_scale_8(au8_shaded[0], u8_bright);
+            au8_shaded[1] = np_scale_8(au8_shaded[1], u8_bright);
+            au8_shaded[2] = np_scale_8(au8_shaded[2], u8_bright);
+        }
+    #endif
+    }
     
     // Disable interrupts
     sreg_prev = SREG;
@@ -192,84 +274,98 @@ void np_show(void) {
 
     // `masklo` and `maskhi` are written to PORT to drive the DATA line low or
     // high (rather than setting or clearing the bit in PORT)
+#ifdef CLK_PLL_EN
+    bool b_fast = (clock_get() == CLK_SEL_16MHZ);
+#endif
+
     maskhi =  bitSetRet(*port, NP_PIN);
     masklo	= bitClearRet(*port, NP_PIN);
 
-    while (datlen--) {
-        curbyte = *data++;
-        
-        __asm__ volatile(
-        "       ldi   %0,8  \n\t"
-        "loop%=:            \n\t"
-        "       st    X,%3 \n\t"    //  '1' [02] '0' [02] - re
-    
-    // Check bits in the cycle count for this wait step. Add the appropriate number of NOPs.
-    #if (w_wait1_cyc & 1)
-    w_nop1
-    #endif
-    #if (w_wait1_cyc & 2)
-    w_nop2
-    #endif
-    #if (w_wait1_cyc & 4)
-    w_nop4
-    #endif
-    #if (w_wait1_cyc & 8)
-    w_nop8
-    #endif
-    #if (w_wait1_cyc & 16)
-    w_nop16
-    #endif
-        "       sbrs  %1,7  \n\t"    //  '1' [04] '0' [03]
-        "       st    X,%4 \n\t"     //  '1' [--] '0' [05] - fe-low
-        "       lsl   %1    \n\t"    //  '1' [05] '0' [06]
+    for (uint8_t u8_pixIdx = 0; u8_pixIdx < u8_pixCnt; u8_pixIdx++) {
 
-    // Check bits in the cycle count for this wait step. Add the appropriate number of NOPs.
-    #if (w_wait2_cyc & 1)
-    w_nop1
-    #endif
-    #if (w_wait2_cyc & 2)
-    w_nop2
-    #endif
-    #if (w_wait2_cyc & 4)
-    w_nop4
-    #endif
-    #if (w_wait2_cyc & 8)
-    w_nop8
-    #endif
-    #if (w_wait2_cyc & 16)
-    w_nop16 
+    #ifdef NP_SHOW_ISR_WINDOW_EN
+        // Service a pending millis() tick before the next one can be lost. The
+        // instruction after sei() always runs before an interrupt is taken.
+        if ((TIFR & _BV(TOV0)) && (sreg_prev & _BV(SREG_I))) {
+            sei();
+            __asm__ volatile("nop");
+            cli();
+        }
     #endif
-        "       brcc skipone%= \n\t"    //  '1' [+1] '0' [+2] - 
-        "       st   X,%4      \n\t"    //  '1' [+3] '0' [--] - fe-high
-        "skipone%=:               "     //  '1' [+3] '0' [+2] - 
 
-    // Check bits in the cycle count for this wait step. Add the appropriate number of NOPs.
-    #if (w_wait3_cyc & 1)
-    w_nop1
-    #endif
-    #if (w_wait3_cyc & 2)
-    w_nop2
-    #endif
-    #if (w_wait3_cyc & 4)
-    w_nop4
-    #endif
-    #if (w_wait3_cyc & 8)
-    w_nop8
-    #endif
-    #if (w_wait3_cyc & 16)
-    w_nop16
+        // Compute the pixel in the gap before it is sent. The data line idles low
+        // here, and WS2812B latch after 50 usec. The shader plus the scaling of the
+        // first byte below have a budget of about 20 usec (160 cycles), see np_shader_t.
+        if (pf_shader != NULL) {
+            uint32_t u32_color = pf_shader(u8_pixIdx);
+            au8_shaded[0] = (uint8_t)(u32_color >>  8);   // GRB transmit order
+            au8_shaded[1] = (uint8_t)(u32_color >> 16);
+            au8_shaded[2] = (uint8_t)(u32_color >>  0);
+        #ifndef NP_SCALE_ON_SHOW_EN
+            if (u8_bright) {
+                au8_shaded[0] = np_scale_8(au8_shaded[0], u8_bright);
+                au8_shaded[1] = np_scale_8(au8_shaded[1], u8_bright);
+                au8_shaded[2] = np_scale_8(au8_shaded[2], u8_bright);
+            }
+        #endif
+            data = au8_shaded;
+        }
+        else if (b_monoPending) {
+            data = (u32_mask & 1) ? au8_shaded : au8_unlit;
+            u32_mask >>= 1;
+        }
+    #ifdef NP_FB_PALETTE_EN
+        else {
+            // Expand the palette index in the gap before the pixel is sent
+            data = &au8_palette[np_pal_get_idx(u8_pixIdx) * NP_BYTES_PER_PIXEL];
+        }
     #endif
 
-        "       dec   %0    \n\t"    //  '1' [+4] '0' [+3]
-        "       brne  loop%=\n\t"    //  '1' [+5] '0' [+4]
-        :	"=&d" (bitctr)
-        :	"r" (curbyte), "x" (port), "r" (maskhi), "r" (masklo)
-        );
+        for (u8_byteCnt = NP_BYTES_PER_PIXEL; u8_byteCnt; u8_byteCnt--) {
+            curbyte = *data++;
+            u8_wireLit |= curbyte;
+
+            // Scale the byte in the gap before it is sent. The line idles low here, well short of the latch time.
+        #ifdef NP_GAMMA_ON_SHOW_EN
+            curbyte = pgm_read_byte(&_au8_NeoPixelGammaTable[curbyte]);
+        #endif
+        #ifdef NP_SCALE_ON_SHOW_EN
+            if (u8_bright) { curbyte = np_scale_8(curbyte, u8_bright); } // See notes in setBrightness()
+        #endif
+        
+            u16_wireSum += curbyte;
+
+        #ifdef CLK_PLL_EN
+            if (b_fast) { np_send_byte(w_fast_mhz); }
+            else
+        #endif
+            { np_send_byte(w_base_mhz); }
+        }
     }
     
     SREG = sreg_prev;
 
-    u16_endTime = micros(); // Save EOD time for latch on next call
+    // The level is summed on the wire. Pixels past a shorter stream kept their color,
+    // which is still the data in RAM. Shaded and mono frames are always sent in full.
+    uint16_t u16_restSum = (u8_pixCnt < u8_numPix) ? np_frame_sum(u8_pixCnt) : 0;
+    b_dark = (u8_wireLit == 0) && (u16_restSum == 0);
+#ifdef NP_SCALE_ON_SHOW_EN
+    if (u8_bright) { u16_restSum = ((uint32_t)u16_restSum * u8_bright) >> 8; }
+#endif
+    u16_level = u16_wireSum + u16_restSum;
+
+    // The pixels now hold the shaded or mono frame rather than the data in RAM,
+    // so the next buffered show() must resend everything
+    b_monoLatched = b_monoPending && (pf_shader == NULL);
+    if ((pf_shader != NULL) || b_monoPending) {
+        pf_shader = NULL;
+        b_monoPending = false;
+        u8_txPixCnt = u8_numPix;
+    }
+
+    u16_endUsec = (uint16_t)micros(); // Save EOD time for latch on next call
+
+    clock_set(u8_clkPrev);
 }
 
 /*!
@@ -283,26 +379,129 @@ void np_show(void) {
 void np_set_pix_color(uint8_t u8_index, uint8_t u8_red, uint8_t u8_green, uint8_t u8_blue) {
     
     // Verify that the index is in range
-    if (u8_index < NP_PIXEL_COUNT) {
+    if (u8_index < u8_numPix) {
 
+    #ifndef NP_SCALE_ON_SHOW_EN
         // Scale brightness of each color
         if (u8_brightness) { // See notes in setBrightness()
-            u8_red =   (u8_red   * u8_brightness)   >> 8;
-            u8_green = (u8_green * u8_brightness)   >> 8;
-            u8_blue =  (u8_blue  * u8_brightness)   >> 8;
+            u8_red =   np_scale_8(u8_red,   u8_brightness);
+            u8_green = np_scale_8(u8_green, u8_brightness);
+            u8_blue =  np_scale_8(u8_blue,  u8_brightness);
         }
+    #endif
+
+        np_set_pix_grb(u8_index, u8_green, u8_red, u8_blue);
+    }
+}
+
+/*!
+    @brief   Store already scaled color data for a pixel, tracking the change
+                     for the next show(). Index must be in range.
+*/
+static void np_set_pix_grb(uint8_t u8_index, uint8_t u8_green, uint8_t u8_red, uint8_t u8_blue) {
+
+#ifdef NP_FB_PALETTE_EN
+    np_pal_set_idx(u8_index, np_pal_find(u8_green, u8_red, u8_blue));
+#else
+    // Lookup location in pixel data array
+    uint8_t* pu8_pixStart;
+    pu8_pixStart = &au8_pixelData[u8_index * 3];    // 3 bytes per pixel
 
-        // Lookup location in pixel data array
-        uint8_t* pu8_pixStart;
-        pu8_pixStart = &au8_pixelData[u8_index * 3];    // 3 bytes per pixel
+    // Only flag a change if the data differs, so re-drawing a static frame costs no transmit
+    if ((pu8_pixStart[0] != u8_green) || (pu8_pixStart[1] != u8_red) || (pu8_pixStart[2] != u8_blue)) {
+        if (u8_index >= u8_txPixCnt) { u8_txPixCnt = u8_index + 1; }
 
         // GRB transmit order
         pu8_pixStart[0] = u8_green;
         pu8_pixStart[1] = u8_red;
         pu8_pixStart[2] = u8_blue;
     }
+#endif
+}
+
+#ifdef NP_FB_PALETTE_EN
+/*!
+    @brief   Read a pixel's palette index. Index must be in range.
+*/
+static uint8_t np_pal_get_idx(uint8_t u8_index) {
+    uint8_t u8_pair = au8_pixelIdx[u8_index >> 1];
+
+    return (u8_index & 1) ? (u8_pair >> 4) : (u8_pair & 0x0F);
+}
+
+/*!
+    @brief   Set a pixel's palette index, tracking the change for the next
+                     show(). Index must be in range.
+*/
+static void np_pal_set_idx(uint8_t u8_index, uint8_t u8_palIdx) {
+    uint8_t* pu8_pair = &au8_pixelIdx[u8_index >> 1];
+
+    if (np_pal_get_idx(u8_index) != u8_palIdx) {
+        if (u8_index >= u8_txPixCnt) { u8_txPixCnt = u8_index + 1; }
+
+        if (u8_index & 1) { *pu8_pair = (*pu8_pair & 0x0F) | (u8_palIdx << 4); }
+        else              { *pu8_pair = (*pu8_pair & 0xF0) | u8_palIdx; }
+    }
+}
+
+/*!
+    @brief   Get the palette entry for a GRB color, adding it if needed. When
+                     the palette is full, an entry no pixel refers to anymore is
+                     reused. If every entry is in use, the closest color is returned.
+    @return  Palette index.
+*/
+static uint8_t np_pal_find(uint8_t u8_green, uint8_t u8_red, uint8_t u8_blue) {
+    uint8_t* pu8_entry = au8_palette;
+    uint8_t  u8_palIdx;
+
+    for (u8_palIdx = 0; u8_palIdx < u8_palUsed; u8_palIdx++, pu8_entry += NP_BYTES_PER_PIXEL) {
+        if ((pu8_entry[0] == u8_green) && (pu8_entry[1] == u8_red) && (pu8_entry[2] == u8_blue)) {
+            return u8_palIdx;
+        }
+    }
+
+    if (u8_palUsed < NP_PAL_SIZE) {
+        u8_palIdx = u8_palUsed++;
+    } else {
+        // Palette full. Look for an entry that is no longer referenced (never entry 0, black).
+        uint16_t u16_refMask = 1;
+        for (uint8_t u8_index = 0; u8_index < u8_numPix; u8_index++) {
+            u16_refMask |= (1 << np_pal_get_idx(u8_index));
+        }
+
+        for (u8_palIdx = 1; u8_palIdx < NP_PAL_SIZE; u8_palIdx++) {
+            if (!(u16_refMask & (1 << u8_palIdx))) { break; }
+        }
+
+        if (u8_palIdx == NP_PAL_SIZE) {
+            // All entries in use, settle for the closest color
+            uint16_t u16_bestDist = 0xFFFF;
+            uint8_t  u8_bestIdx = 0;
+
+            pu8_entry = au8_palette;
+            for (u8_palIdx = 0; u8_palIdx < NP_PAL_SIZE; u8_palIdx++, pu8_entry += NP_BYTES_PER_PIXEL) {
+                uint16_t u16_dist = np_abs_diff(pu8_entry[0], u8_green) +
+                                    np_abs_diff(pu8_entry[1], u8_red) +
+                                    np_abs_diff(pu8_entry[2], u8_blue);
+                if (u16_dist < u16_bestDist) { u16_bestDist = u16_dist; u8_bestIdx = u8_palIdx; }
+            }
+            return u8_bestIdx;
+        }
+    }
+
+    pu8_entry = &au8_palette[u8_palIdx * NP_BYTES_PER_PIXEL];
+    pu8_entry[0] = u8_green;
+    pu8_entry[1] = u8_red;
+    pu8_entry[2] = u8_blue;
+
+    return u8_palIdx;
 }
 
+static inline uint8_t np_abs_diff(uint8_t u8_a, uint8_t u8_b) {
+    return (u8_a > u8_b) ? (u8_a - u8_b) : (u8_b - u8_a);
+}
+#endif
+
 
 /*!
     @brief   Set a pixel's color using a 32-bit 'packed' RGB value.
@@ -340,25 +539,45 @@ void np_fill(uint32_t u32_color, uint8_t u8_firstIndex, uint8_t u8_count) {
     uint8_t u8_endPix;
 
     // If first LED is past end of strip, nothing to do
-    if (u8_firstIndex >= NP_PIXEL_COUNT) {
+    if (u8_firstIndex >= u8_numPix) {
         return;
     }
 
     // Calculate the index ONE AFTER the last pixel to fill
     if (u8_count == 0) {
         // Fill to end of strip
-        u8_endPix = NP_PIXEL_COUNT;
+        u8_endPix = u8_numPix;
     } else {
         // Ensure that the loop won't go past the last pixel
         u8_endPix = u8_firstIndex + u8_count;
-        if (u8_endPix > NP_PIXEL_COUNT) {
-            u8_endPix = NP_PIXEL_COUNT;
+        if (u8_endPix > u8_numPix) {
+            u8_endPix = u8_numPix;
         }
     }
 
+    // Extract and scale the color once, then copy it to each pixel
+    uint8_t u8_red =   (uint8_t)(u32_color >> 16);
+    uint8_t u8_green = (uint8_t)(u32_color >>  8);
+    uint8_t u8_blue =  (uint8_t)(u32_color >>  0);
+
+#ifndef NP_SCALE_ON_SHOW_EN
+    if (u8_brightness) { // See notes in setBrightness()
+        u8_red =   np_scale_8(u8_red,   u8_brightness);
+        u8_green = np_scale_8(u8_green, u8_brightness);
+        u8_blue =  np_scale_8(u8_blue,  u8_brightness);
+    }
+#endif
+
+#ifdef NP_FB_PALETTE_EN
+    uint8_t u8_palIdx = np_pal_find(u8_green, u8_red, u8_blue);
+    for (u8_index = u8_firstIndex; u8_index < u8_endPix; u8_index++) {
+        np_pal_set_idx(u8_index, u8_palIdx);
+    }
+#else
     for (u8_index = u8_firstIndex; u8_index < u8_endPix; u8_index++) {
-        np_set_pix_color_pack(u8_index, u32_color);
+        np_set_pix_grb(u8_index, u8_green, u8_red, u8_blue);
     }
+#endif
 }
 
 void np_fill_all(uint32_t u32_color) {
@@ -402,7 +621,11 @@ uint32_t np_hsv_to_pack(uint16_t u16_hue, uint8_t u8_sat, uint8_t u8_val) {
     // (not 1536, more on that below), but the full unsigned 16-bit type was
     // chosen for hue so that one's code can easily handle a contiguous color
     // wheel by allowing hue to roll over in either direction.
-    u16_hue = (u16_hue * 1530L + 32768) / 65536;
+    // u16_hue = (u16_hue * 1530L + 32768) / 65536;
+    // Without a hardware multiplier, compute 1530 * hue as (3 * hue) * 510 = (3 * hue) * 512 - (3 * hue) * 2.
+    // Only shifts and adds, and the shift by 16 is just a byte select.
+    uint32_t u32_hue3 = (uint32_t)u16_hue + ((uint32_t)u16_hue << 1);
+    u16_hue = (uint16_t)(((u32_hue3 << 9) - (u32_hue3 << 1) + 32768) >> 16);
     // Because red is centered on the rollover point (the +32768 above,
     // essentially a fixed-point +0.5), the above actually yields 0 to 1530,
     // where 0 and 1530 would yield the same thing. Rather than apply a
@@ -457,35 +680,40 @@ uint32_t np_hsv_to_pack(uint16_t u16_hue, uint8_t u8_sat, uint8_t u8_val) {
         u8_green = u8_blue = 0;
     }
 
-    // Apply saturation and value to R,G,B, pack into 32-bit result:
-    uint32_t u32_valPlus1 =   1 + u8_val;  // 1 to 256; allows >>8 instead of /255
-    uint16_t u16_satPlus1 =   1 + u8_sat;  // 1 to 256; same reason
+    // Apply saturation and value to R,G,B, pack into 32-bit result.
+    // Scaling by (sat + 1) and (val + 1) allows >>8 instead of /255. Fully saturated, full value
+    // colors (the hue-only case) pass through unchanged.
     uint8_t  u8_satInvert = 255 - u8_sat;  // 255 to 0
 
-    return ((((((u8_red   * u16_satPlus1) >> 8) + u8_satInvert) * u32_valPlus1) & 0xff00)  << 8)  |
-            (((((u8_green * u16_satPlus1) >> 8) + u8_satInvert) * u32_valPlus1) & 0xff00)         |
-            (((((u8_blue  * u16_satPlus1) >> 8) + u8_satInvert) * u32_valPlus1)            >> 8);
+    u8_red =   np_scale_8_plus1(np_scale_8_plus1(u8_red,   u8_sat) + u8_satInvert, u8_val);
+    u8_green = np_scale_8_plus1(np_scale_8_plus1(u8_green, u8_sat) + u8_satInvert, u8_val);
+    u8_blue =  np_scale_8_plus1(np_scale_8_plus1(u8_blue,  u8_sat) + u8_satInvert, u8_val);
+
+    return np_rgb_to_pack(u8_red, u8_green, u8_blue);
 }
 
 uint32_t   np_hsv_to_pack_hue(uint16_t u16_hue) {
     return np_hsv_to_pack(u16_hue, 255, 255);
 }
 
+uint32_t   np_hue_to_pack_gamma(uint16_t u16_hue) {
+    const uint8_t *pu8_entry = &_au8_NeoPixelHueGammaTable[NP_HUE_TABLE_INDEX(u16_hue) * 3];
+
+    return np_rgb_to_pack(pgm_read_byte(pu8_entry), pgm_read_byte(pu8_entry + 1), pgm_read_byte(pu8_entry + 2));
+}
+
 
 /*!
     @brief   Adjust output brightness. Does not immediately affect what's
                      currently displayed on the LEDs. The next call to show() will
                      refresh the LEDs at this level.
     @param   b  Brightness setting, 0=minimum (off), 255=brightest.
-    @note    This was intended for one-time use in one's setup() function,
-                     not as an animation effect in itself. Because of the way this
-                     library "pre-multiplies" LED colors in RAM, changing the
-                     brightness is often a "lossy" operation -- what you write to
-                     pixels isn't necessary the same as what you'll read back.
-                     Repeated brightness changes using this function exacerbate the
-                     problem. Smart programs therefore treat the strip as a
-                     write-only resource, maintaining their own state to render each
-                     frame of an animation, not relying on read-modify-write.
+    @note    With NP_SCALE_ON_SHOW_EN, the brightness is applied while streaming,
+                     so changing it is lossless and the whole strip is resent on the
+                     next show(). Otherwise, because the library "pre-multiplies" LED
+                     colors in RAM, changing the brightness is often a "lossy" operation
+                     -- what you write to pixels isn't necessary the same as what you'll
+                     read back -- and it only affects pixels written afterwards.
 */
 void np_set_brightness(uint8_t u8_brightness_in) {
     // Stored brightness value is different than what's passed.
@@ -494,7 +722,14 @@ void np_set_brightness(uint8_t u8_brightness_in) {
     // adding 1 here may (intentionally) roll over...so 0 = max brightness
     // (color values are interpreted literally; no scaling), 1 = min
     // brightness (off), 255 = just below max brightness.
-    u8_brightness = u8_brightness_in + 1;
+    if (u8_brightness != (uint8_t)(u8_brightness_in + 1)) {
+        u8_brightness = u8_brightness_in + 1;
+
+    #ifdef NP_SCALE_ON_SHOW_EN
+        // Every byte on the wire changes
+        np_refresh_all();
+    #endif
+    }
 
     // Removed the rescaling code because I don't need it in my application.
 }
@@ -511,7 +746,69 @@ uint8_t np_get_brightness(void) {
     @brief   Fill the whole NeoPixel strip with 0 / black / off.
 */
 void np_clear(void) {
-    util_memset(au8_pixelData, 0, NP_ARR_SIZE);
+#ifdef NP_FB_PALETTE_EN
+    uint8_t u8_i = u8_numPix;
+
+    // Find the last lit pixel. Nothing past it changes.
+    do {
+        u8_i--;
+        if (np_pal_get_idx(u8_i)) {
+            if (u8_i >= u8_txPixCnt) { u8_txPixCnt = u8_i + 1; }
+            break;
+        }
+    } while (u8_i);
+
+    // Every pixel now refers to black, so the palette starts over
+    util_memset(au8_pixelIdx, 0, NP_PAL_IDX_ARR_SIZE);
+    u8_palUsed = 1;
+#else
+    uint8_t u8_i = u8_numPix * NP_BYTES_PER_PIXEL;
+
+    // Find the last lit pixel. Nothing past it changes.
+    do {
+        u8_i--;
+        if (au8_pixelData[u8_i]) {
+            uint8_t u8_pixCnt = u8_i / NP_BYTES_PER_PIXEL + 1;
+            if (u8_pixCnt > u8_txPixCnt) { u8_txPixCnt = u8_pixCnt; }
+
+            util_memset(au8_pixelData, 0, u8_i + 1);
+            break;
+        }
+    } while (u8_i);
+#endif
+}
+
+/*!
+    @brief   Compute the pixels of the next show() with a shader instead of
+                     sending the pixel data in RAM. Applies to that show() only.
+    @param   pf_shaderIn  Shader called for each pixel, see np_shader_t.
+*/
+void np_set_shader(np_shader_t pf_shaderIn) {
+    pf_shader = pf_shaderIn;
+}
+
+/*!
+    @brief   Send the next show() as a single color frame, leaving the pixel
+                     data in RAM alone. Applies to that show() only.
+    @param   u32_mask   Lit pixels, bit 0 = pixel 0.
+    @param   u32_color  Packed RGB color of the lit pixels.
+*/
+void np_set_mono(uint32_t u32_mask, uint32_t u32_color) {
+    if ((u32_mask != u32_monoMask) || (u32_color != u32_monoColor)) {
+        u32_monoMask = u32_mask;
+        u32_monoColor = u32_color;
+        b_monoLatched = false;
+    }
+    b_monoPending = true;
+}
+
+/*!
+    @brief   Force the next show() to send the whole strip, e.g. after the
+                     pixels lost power and their latched data.
+*/
+void np_refresh_all(void) {
+    u8_txPixCnt = u8_numPix;
+    b_monoLatched = false;
 }
 
   /*!
@@ -559,9 +856,122 @@ uint32_t   np_rgb_to_pack(uint8_t u8_red, uint8_t u8_green, uint8_t u8_blue) {
 }
 
 bool np_can_show(void) {
-    return ((uint16_t)micros()-u16_endTime) >= 300;
+    return np_latch_remaining_usec() == 0;
+}
+
+uint16_t np_latch_remaining_usec(void) {
+    uint16_t u16_elapsed = (uint16_t)micros() - u16_endUsec;
+
+    // Elapsed time wraps after 65 msec. A stale reference only costs one extra latch wait.
+    if (u16_elapsed >= NP_LATCH_WAIT_USEC) { return 0; }
+
+    return NP_LATCH_WAIT_USEC - u16_elapsed;
+}
+
+void np_set_length(uint8_t u8_numPixIn) {
+    if ((u8_numPixIn == 0) || (u8_numPixIn > NP_PIXEL_COUNT_MAX)) { u8_numPixIn = NP_PIXEL_COUNT_MAX; }
+
+    u8_numPix = u8_numPixIn;
+
+    // Clear the data past the new length, so it is black if the length grows again
+#ifdef NP_FB_PALETTE_EN
+    for (uint8_t u8_i = u8_numPix; u8_i < NP_PIXEL_COUNT_MAX; u8_i++) {
+        if (u8_i & 1) { au8_pixelIdx[u8_i >> 1] &= 0x0F; }
+        else          { au8_pixelIdx[u8_i >> 1] &= 0xF0; }
+    }
+#else
+    // util_memset() writes at least one byte
+    if (u8_numPix < NP_PIXEL_COUNT_MAX) {
+        util_memset(&au8_pixelData[u8_numPix * NP_BYTES_PER_PIXEL], 0, (NP_PIXEL_COUNT_MAX - u8_numPix) * NP_BYTES_PER_PIXEL);
+    }
+#endif
+
+    np_refresh_all();
 }
 
 uint8_t np_get_length(void) {
-    return NP_PIXEL_COUNT;
+    return u8_numPix;
+}
+
+uint32_t np_get_show_count(void) {
+    return u32_showCnt;
+}
+
+uint32_t np_get_skip_count(void) {
+    return u32_skipCnt;
+}
+
+void np_power_on(void) {
+    if (b_powerOn) { return; }
+
+    bitSet(NP_PWR_DDR, NP_PWR_PIN);     // Enable MOSFET for NeoPixel power
+    bitSet(NP_PWR_PORT, NP_PWR_PIN);
+    bitClear(NP_PORT, NP_PIN);          // Data idles low, as in np_init()
+    bitSet(NP_DDR, NP_PIN);
+    delay_msec(NP_PWR_SETTLE_MSEC);
+
+    b_powerOn = true;
+    b_dark = true;                      // Fresh pixels power up dark,
+    np_refresh_all();                   // with no latched data
+}
+
+void np_power_off(void) {
+    bitClear(NP_DDR, NP_PIN);           // Hi-Z to save power
+    bitSet(NP_PORT, NP_PIN);            // Pull-up, so the data line can't power the pixels
+    bitClear(NP_PWR_DDR, NP_PWR_PIN);   // Hi-Z to turn off MOSFET
+    bitClear(NP_PWR_PORT, NP_PWR_PIN);  // No Pull-up, there is external pull-down
+
+    b_powerOn = false;
+    b_dark = true;
+}
+
+bool np_power_is_on(void) {
+    return b_powerOn;
+}
+
+bool np_is_dark(void) {
+    return b_dark;
+}
+
+uint16_t np_get_level(void) {
+    return b_powerOn ? u16_level : 0;
+}
+
+/*!
+    @brief   Sum the color bytes of the next show(), from a pixel to the end of
+                        the pixels in use, before brightness scaling. 0 means
+                        those pixels are black. A mono frame is summed in full.
+                        Shaded frames are unknown until sent.
+    @param   u8_first  First pixel to sum.
+    @return  Byte sum, 0 to 19125 for 25 pixels. 0 for a shaded frame.
+*/
+static uint16_t np_frame_sum(uint8_t u8_first) {
+    uint16_t u16_sum = 0;
+    uint8_t u8_i;
+
+    if (pf_shader != NULL) { return 0; }
+
+    if (b_monoPending) {
+        uint32_t u32_mask = u32_monoMask;
+        uint8_t u8_lit = 0;
+
+        for (u8_i = u8_numPix; u8_i && u32_mask; u8_i--) {
+            u8_lit += (uint8_t)u32_mask & 1;
+            u32_mask >>= 1;
+        }
+        return u8_lit * ((uint16_t)(uint8_t)(u32_monoColor >> 16) + (uint8_t)(u32_monoColor >> 8) + (uint8_t)u32_monoColor);
+    }
+
+#ifdef NP_FB_PALETTE_EN
+    for (u8_i = u8_first; u8_i < u8_numPix; u8_i++) {
+        uint8_t* pu8_color = &au8_palette[np_pal_get_idx(u8_i) * NP_BYTES_PER_PIXEL];
+        u16_sum += (uint16_t)pu8_color[0] + pu8_color[1] + pu8_color[2];
+    }
+#else
+    for (u8_i = u8_first * NP_BYTES_PER_PIXEL; u8_i < (uint8_t)(u8_numPix * NP_BYTES_PER_PIXEL); u8_i++) {
+        u16_sum += au8_pixelData[u8_i];
+    }
+#endif
+
+    return u16_sum;
 }
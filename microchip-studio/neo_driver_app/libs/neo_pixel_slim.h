@@ -49,9 +49,83 @@ extern "C"{
 #define NP_PORT             (PORTB)
 #define NP_DDR              (DDRB)
 #define NP_PIN              (3)     // PB3, ADC3 - NeoPixel Data
-#define NP_PIXEL_COUNT      (25)
+#define NP_PWR_PORT         (PORTB)
+#define NP_PWR_DDR          (DDRB)
+#define NP_PWR_PIN          (2)     // PB2, ADC1 - NeoPixel Enable, low side MOSFET. Also switches the pot GND.
+#define NP_PWR_SETTLE_MSEC  (5)     // Time for the MOSFET to switch on and the pixels to power up
+#define NP_PIXEL_COUNT_MAX  (25)    // Pixel data is allocated for this many. The count in use is set at runtime.
 #define NP_BYTES_PER_PIXEL  (3)     // GRB order
-#define NP_ARR_SIZE         (NP_PIXEL_COUNT * NP_BYTES_PER_PIXEL)
+#define NP_ARR_SIZE         (NP_PIXEL_COUNT_MAX * NP_BYTES_PER_PIXEL)
+#define NP_LATCH_USEC       (300)   // Quiet time after the last bit before the pixels latch
+#define NP_LATCH_WAIT_USEC  (NP_LATCH_USEC + MICROS_RES_USEC)   // Two micros() readings can be a tick off
+
+/*
+ * Brightness scaling mode
+ *
+ * NP_SCALE_ON_SHOW_EN defined:  The pixel data in RAM holds unscaled color. Brightness is applied
+ *                               to each byte as it is streamed out by show(), so a brightness change
+ *                               is lossless and drawing code does no scaling.
+ * NP_SCALE_ON_SHOW_EN undefined: Colors are pre-multiplied by the brightness when they are written.
+ *
+ * NP_GAMMA_ON_SHOW_EN additionally passes every byte through the gamma table during show(). Drawing code
+ * should then use linear colors, not np_get_gamma_8()/np_get_gamma_32().
+ */
+#define NP_SCALE_ON_SHOW_EN
+// #define NP_GAMMA_ON_SHOW_EN
+
+#if defined(NP_GAMMA_ON_SHOW_EN) && !defined(NP_SCALE_ON_SHOW_EN)
+  #error "NP_GAMMA_ON_SHOW_EN requires NP_SCALE_ON_SHOW_EN"
+#endif
+
+/*
+ * Framebuffer mode
+ *
+ * NP_FB_PALETTE_EN undefined: 3 bytes of GRB per pixel (NP_ARR_SIZE bytes of RAM).
+ * NP_FB_PALETTE_EN defined:   4-bit palette index per pixel, plus a palette of NP_PAL_SIZE GRB colors.
+ *                             Indices are expanded to GRB by show(), in the gap before each pixel. Frames
+ *                             with more than NP_PAL_SIZE distinct colors get the closest palette color.
+ *                             Saves RAM once NP_PIXEL_COUNT_MAX/2 + 3*NP_PAL_SIZE < 3*NP_PIXEL_COUNT_MAX.
+ */
+// #define NP_FB_PALETTE_EN
+#define NP_PAL_SIZE         (16)    // Palette entries, 2-16
+#define NP_PAL_IDX_ARR_SIZE ((NP_PIXEL_COUNT_MAX + 1) / 2)
+
+#if (NP_PAL_SIZE < 2) || (NP_PAL_SIZE > 16)
+  #error "NP_PAL_SIZE must be 2-16 (4-bit index)"
+#endif
+
+/*
+ * Interrupt window
+ *
+ * NP_SHOW_ISR_WINDOW_EN defined: show() briefly enables interrupts in the gap between pixels when a Timer0
+ *                                overflow is pending, so the millis() tick is serviced. Interrupts are then
+ *                                blocked for one pixel at most (~30 usec), and no tick is lost however long
+ *                                the transmit (pixel count, shader time). Costs the ISR time (~15 usec at
+ *                                8 MHz, the same for every overflow) in one gap per overflow. With the
+ *                                shader budget (see np_shader_t) that gap stays under the 50 usec WS2812B
+ *                                reset time, but parts that latch sooner will show a corrupted frame.
+ * NP_SHOW_ISR_WINDOW_EN undefined: Interrupts stay off for the whole transmit. A tick is lost whenever a
+ *                                transmit spans two overflows. With TIMER0_TICKLESS_EN they are 32.768 msec
+ *                                apart, far longer than a transmit (~1 msec for 25 pixels), so nothing is
+ *                                lost. Without it they are 2.048 msec apart, and long shaded transmits
+ *                                can lose a tick.
+ */
+// #define NP_SHOW_ISR_WINDOW_EN
+
+/****************************** TYPEDEFS ******************************/
+/*!
+    @brief   Pixel shader for np_set_shader(). Returns the packed RGB color
+                        of a pixel. Called with interrupts disabled while show() is
+                        streaming, for pixels 0 to np_get_length()-1 in order, so a
+                        shader may step its own state instead of recomputing from the
+                        index. The shader, the brightness scaling of the first byte
+                        (~32 cycles with NP_SCALE_ON_SHOW_EN) and the loop share one
+                        low gap, budgeted at about 20 usec (160 cycles at 8 MHz). The
+                        shaders in anim.c take about 120 in all. WS2812B latch after
+                        50 usec low (280 usec on V5 parts). The original WS2812 can
+                        latch after about 9 usec and is not supported in this mode.
+*/
+typedef uint32_t (*np_shader_t)(uint8_t u8_pixIdx);
 
 /*
  * Internal defines
@@ -76,54 +150,44 @@ extern "C"{
 #define w_fixedhigh   (6)
 #define w_fixedtotal  (10)
 
-// Insert NOPs to match the timing, if possible
-// Computes to 2.
-#define w_t0h_target_cyc    (w_t0h_target_nsec / nanosecondsPerClockCycle())
-// Computes to 7.
-#define w_t1h_target_cyc     (w_t1h_target_nsec / nanosecondsPerClockCycle())
-// Computes to 10.
-#define w_totalperiod_target_cyc   (w_totalperiod_target_nsec / nanosecondsPerClockCycle())
-
-// wait1 - nops between rising edge and falling edge - low
-#if (w_t0h_target_cyc > w_fixedlow)
-  #define w_wait1_cyc (w_t0h_target_cyc - w_fixedlow)
-#else
-  #define w_wait1_cyc  (0)
-#endif
+// Clocks with a show kernel. The fast kernel is used when clock_set(CLK_SEL_16MHZ) is active.
+#define w_base_mhz    (F_CPU / 1000000UL)
+#define w_fast_mhz    (2 * w_base_mhz)
 
-// wait2 - nops between fe low and fe high
-#if (w_t1h_target_cyc > (w_fixedhigh + w_wait1_cyc))
-  #define w_wait2_cyc (w_t1h_target_cyc - w_fixedhigh - w_wait1_cyc)
-#else
-  #define w_wait2_cyc  (0)
-#endif
+// Insert NOPs to match the timing, if possible, for a clock of `mhz`
+// Computes to 2 at 8 MHz, 5 at 16 MHz.
+#define w_t0h_target_cyc(mhz)         ((w_t0h_target_nsec * (mhz)) / 1000)
+// Computes to 7 at 8 MHz, 14 at 16 MHz.
+#define w_t1h_target_cyc(mhz)         ((w_t1h_target_nsec * (mhz)) / 1000)
+// Computes to 10 at 8 MHz, 20 at 16 MHz.
+#define w_totalperiod_target_cyc(mhz) ((w_totalperiod_target_nsec * (mhz)) / 1000)
 
-// wait3 - nops to complete loop
-#if (w_totalperiod_target_cyc > (w_fixedtotal + w_wait1_cyc + w_wait2_cyc))
-  #define w_wait3_cyc (w_totalperiod_target_cyc - w_fixedtotal - w_wait1_cyc - w_wait2_cyc)
-#else
-  #define w_wait3_cyc  (0)
-#endif
+// Difference clamped at zero
+#define w_sat_sub(a, b)     (((a) > (b)) ? ((a) - (b)) : 0)
+
+// wait1 - nops between rising edge and falling edge - low. 0 at 8 MHz, 2 at 16 MHz.
+#define w_wait1_cyc(mhz)    w_sat_sub(w_t0h_target_cyc(mhz), w_fixedlow)
+// wait2 - nops between fe low and fe high. 1 at 8 MHz, 6 at 16 MHz.
+#define w_wait2_cyc(mhz)    w_sat_sub(w_t1h_target_cyc(mhz), w_fixedhigh + w_wait1_cyc(mhz))
+// wait3 - nops to complete loop. 0 at 8 MHz, 2 at 16 MHz.
+#define w_wait3_cyc(mhz)    w_sat_sub(w_totalperiod_target_cyc(mhz), w_fixedtotal + w_wait1_cyc(mhz) + w_wait2_cyc(mhz))
 
 // The only critical timing parameter is the minimum pulse length of the "0"
 // Warn or throw error if this timing can not be met with current F_CPU settings.
-#define w_t0h_actual_cyc    (w_wait1_cyc + w_fixedlow)
-#define w_t0h_actual_nsec   (w_t0h_actual_cyc * nanosecondsPerClockCycle())
+#define w_t0h_actual_nsec(mhz)   (((w_wait1_cyc(mhz) + w_fixedlow) * 1000) / (mhz))
 
-#if (w_t0h_actual_nsec > (w_t0h_target_nsec + ((4*w_tolerance_nsec)/3)))
+#if (w_t0h_actual_nsec(w_base_mhz) > (w_t0h_target_nsec + ((4*w_tolerance_nsec)/3)))
    #error "Light_ws2812: Sorry, the clock speed is too low. Did you set F_CPU correctly?"
-#elif (w_t0h_actual_nsec > (w_t0h_target_nsec + ((2*w_tolerance_nsec)/3)))
+#elif (w_t0h_actual_nsec(w_base_mhz) > (w_t0h_target_nsec + ((2*w_tolerance_nsec)/3)))
    #error "Light_ws2812: The timing is critical and may only work on WS2812B, not on WS2812(S)."
    #error "Please consider a higher clockspeed, if possible"
 #endif
+#if (w_t0h_actual_nsec(w_fast_mhz) > (w_t0h_target_nsec + ((2*w_tolerance_nsec)/3)))
+   #error "Light_ws2812: The fast kernel timing can not be met."
+#endif
 
-// One NOP equals one clock cycle.
-// brid (used to branch to next instruction) delays two clock cycles in one instruction word.
-#define w_nop1  "nop      \n\t"
-#define w_nop2  "brid .+0 \n\t"
-#define w_nop4  w_nop2 w_nop2
-#define w_nop8  w_nop4 w_nop4
-#define w_nop16 w_nop8 w_nop8
+// One NOP equals one clock cycle. Repeated by the assembler, the count must be a constant.
+#define w_nops(op)  ".rept " op " \n\t nop \n\t .endr \n\t"
 
 /*! 
         @brief  Class that stores state and functions for interacting with
@@ -138,6 +202,28 @@ void np_fill(uint32_t u32_color, uint8_t u8_firstIndex, uint8_t u8_count);
 void np_fill_all(uint32_t u32_color);
 void np_set_brightness(uint8_t u8_brightness);
 void np_clear(void);
+void np_refresh_all(void);
+
+/*!
+    @brief   Compute the next show() with a shader instead of sending the
+                        pixel data in RAM. Each pixel is computed just before it is
+                        sent, so a procedural animation skips the render pass and does
+                        not touch the pixel data. Applies to one show() only. The data
+                        in RAM is resent in full on the show() after.
+    @param   pf_shaderIn  Shader function, see np_shader_t.
+*/
+void np_set_shader(np_shader_t pf_shaderIn);
+
+/*!
+    @brief   Send the next show() as a single color frame, without touching the
+                        pixel data in RAM. Set bits of the mask light their pixel with
+                        the color (scaled by the brightness as usual), other pixels are
+                        off. show() is skipped if the pixels already hold the same mono
+                        frame. Applies to one show() only, like np_set_shader().
+    @param   u32_mask   Lit pixels, bit 0 = pixel 0.
+    @param   u32_color  Packed RGB color of the lit pixels.
+*/
+void np_set_mono(uint32_t u32_mask, uint32_t u32_color);
 
 /*!
     @brief   Check whether a call to show() will start sending data
@@ -153,14 +239,69 @@ void np_clear(void);
                         if show() would block (meaning some idle time is available).
 */
 bool              np_can_show(void);
+
+/*!
+    @brief   Time left until the pixels latch the last transmit and show()
+                        can start sending. Lets the caller do useful work instead of
+                        having show() sleep through the rest. Resolution is one Timer0
+                        tick, see MICROS_RES_USEC.
+    @return  Remaining latch time in usec, 0 if show() would send immediately.
+*/
+uint16_t          np_latch_remaining_usec(void);
 uint8_t           np_get_brightness(void);
 
+/*!
+    @brief   Set the number of pixels in use. show(), fill() and the
+                        animations only compute and send this many. Pixel data past
+                        the new length is cleared, but pixels past it keep their
+                        latched color, so clear and show() first if they exist.
+    @param   u8_numPix  Pixel count. Out of range (0 or above NP_PIXEL_COUNT_MAX)
+                        selects NP_PIXEL_COUNT_MAX.
+*/
+void              np_set_length(uint8_t u8_numPix);
+
 /*!
     @brief   Return the number of pixels in an Adafruit_NeoPixel strip object.
-    @return  Pixel count (0 if not set).
+    @return  Pixel count, 1 to NP_PIXEL_COUNT_MAX.
 */
 uint8_t           np_get_length(void);
 
+/*!
+    @brief   Statistics for show(). A call is skipped when no pixel data
+                        (or brightness) changed since the last transmit. Otherwise only
+                        the pixels up to the last changed one are sent.
+    @return  Number of frames transmitted / skipped since power on.
+*/
+uint32_t          np_get_show_count(void);
+uint32_t          np_get_skip_count(void);
+
+/*!
+    @brief   Switch the pixel power rail (NP_PWR_PIN). Even commanded black,
+                        the pixels draw several mA. While the rail is off, show()
+                        skips black frames, and turns the rail back on by itself
+                        (NP_PWR_SETTLE_MSEC, then a full resend) before the first
+                        frame with anything lit.
+*/
+void              np_power_on(void);
+void              np_power_off(void);
+bool              np_power_is_on(void);
+
+/*!
+    @brief   Whether every pixel is dark: the last show() sent an all-black
+                        frame, or skipped one with the rail off. Brightness scaling
+                        is not counted, a byte that only scales to 0 is lit.
+    @return  true if the whole strip is black.
+*/
+bool              np_is_dark(void);
+
+/*!
+    @brief   Light level of the strip: the sum of all color bytes of the
+                        frame last shown, after brightness scaling. The LED current
+                        is roughly proportional to it.
+    @return  0 (dark or rail off) to 19125 (25 pixels of full white).
+*/
+uint16_t          np_get_level(void);
+
 /*!
     @brief   An 8-bit integer sine wave function, not directly compatible
                         with standard trigonometric units like radians or degrees.
@@ -181,8 +322,8 @@ uint8_t    np_get_sine_8(uint8_t u8_x);
                         correct.
     @param   x  Input brightness, 0 (minimum or off/black) to 255 (maximum).
     @return  Gamma-adjusted brightness, can then be passed to one of the
-                        setPixelColor() functions. This uses a fixed gamma correction
-                        exponent of 2.6, which seems reasonably okay for average
+                        setPixelColor() functions. This uses a gamma correction exponent
+                        set at build time (2.6 by default), which seems reasonably okay for average
                         NeoPixels in average tasks. If you need finer control you'll
                         need to provide your own gamma-correction function instead.
 */
@@ -203,6 +344,14 @@ uint32_t   np_rgb_to_pack(uint8_t u8_red, uint8_t u8_green, uint8_t u8_blue);
 // Many applications will only vary the hue
 uint32_t   np_hsv_to_pack_hue(uint16_t u16_hue);
 uint32_t   np_hsv_to_pack(uint16_t u16_hue, uint8_t u8_sat, uint8_t u8_val);
+/*!
+    @brief   Fully saturated hue to gamma-corrected packed RGB, in a single
+                        table read. Same result as np_get_gamma_32(np_hsv_to_pack_hue()),
+                        quantized to NP_HUE_TABLE_SIZE hue steps.
+    @param   u16_hue  Hue, 0-65535 is one full turn of the color wheel.
+    @return  Packed RGB value.
+*/
+uint32_t   np_hue_to_pack_gamma(uint16_t u16_hue);
 
 uint32_t   np_get_gamma_32(uint32_t u32_color);
 
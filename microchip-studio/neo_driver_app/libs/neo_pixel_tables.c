@@ -0,0 +1,114 @@
+/* File:      neo_pixel_tables.c
+ * Author:    Generated by scripts/gen-np-tables.py --gamma 2.6 --hue-size 256. Do not edit.
+ * Purpose:   Flash lookup tables for the NeoPixel library
+ */
+
+#include "neo_pixel_tables.h"
+
+// 8-bit unsigned sine wave (0-255), one full circle
+const uint8_t PROGMEM _au8_NeoPixelSineTable[256] = {
+    128,131,134,137,140,143,146,149,152,155,158,162,165,167,170,173,
+    176,179,182,185,188,190,193,196,198,201,203,206,208,211,213,215,
+    218,220,222,224,226,228,230,232,234,235,237,238,240,241,243,244,
+    245,246,248,249,250,250,251,252,253,253,254,254,254,255,255,255,
+    255,255,255,255,254,254,254,253,253,252,251,250,250,249,248,246,
+    245,244,243,241,240,238,237,235,234,232,230,228,226,224,222,220,
+    218,215,213,211,208,206,203,201,198,196,193,190,188,185,182,179,
+    176,173,170,167,165,162,158,155,152,149,146,143,140,137,134,131,
+    128,124,121,118,115,112,109,106,103,100, 97, 93, 90, 88, 85, 82,
+     79, 76, 73, 70, 67, 65, 62, 59, 57, 54, 52, 49, 47, 44, 42, 40,
+     37, 35, 33, 31, 29, 27, 25, 23, 21, 20, 18, 17, 15, 14, 12, 11,
+     10,  9,  7,  6,  5,  5,  4,  3,  2,  2,  1,  1,  1,  0,  0,  0,
+      0,  0,  0,  0,  1,  1,  1,  2,  2,  3,  4,  5,  5,  6,  7,  9,
+     10, 11, 12, 14, 15, 17, 18, 20, 21, 23, 25, 27, 29, 31, 33, 35,
+     37, 40, 42, 44, 47, 49, 52, 54, 57, 59, 62, 65, 67, 70, 73, 76,
+     79, 82, 85, 88, 90, 93, 97,100,103,106,109,112,115,118,121,124
+};
+
+// 8-bit gamma correction, exponent 2.6
+const uint8_t PROGMEM _au8_NeoPixelGammaTable[256] = {
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  1,  1,  1,  1,  1,  1,  1,  1,
+      1,  1,  1,  1,  2,  2,  2,  2,  2,  2,  2,  2,  3,  3,  3,  3,
+      3,  3,  4,  4,  4,  4,  5,  5,  5,  5,  5,  6,  6,  6,  6,  7,
+      7,  7,  8,  8,  8,  9,  9,  9, 10, 10, 10, 11, 11, 11, 12, 12,
+     13, 13, 13, 14, 14, 15, 15, 16, 16, 17, 17, 18, 18, 19, 19, 20,
+     20, 21, 21, 22, 22, 23, 24, 24, 25, 25, 26, 27, 27, 28, 29, 29,
+     30, 31, 31, 32, 33, 34, 34, 35, 36, 37, 38, 38, 39, 40, 41, 42,
+     42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57,
+     58, 59, 60, 61, 62, 63, 64, 65, 66, 68, 69, 70, 71, 72, 73, 75,
+     76, 77, 78, 80, 81, 82, 84, 85, 86, 88, 89, 90, 92, 93, 94, 96,
+     97, 99,100,102,103,105,106,108,109,111,112,114,115,117,119,120,
+    122,124,125,127,129,130,132,134,136,137,139,141,143,145,146,148,
+    150,152,154,156,158,160,162,164,166,168,170,172,174,176,178,180,
+    182,184,186,188,191,193,195,197,199,202,204,206,209,211,213,215,
+    218,220,223,225,227,230,232,235,237,240,242,245,247,250,252,255
+};
+
+// Gamma-corrected hue wheel, 256 entries of R,G,B. Entry i is hue i * 65536 / 256.
+const uint8_t PROGMEM _au8_NeoPixelHueGammaTable[NP_HUE_TABLE_SIZE * 3] = {
+    255,  0,  0,255,  0,  0,255,  0,  0,255,  0,  0,
+    255,  1,  0,255,  1,  0,255,  2,  0,255,  2,  0,
+    255,  3,  0,255,  5,  0,255,  6,  0,255,  8,  0,
+    255, 10,  0,255, 12,  0,255, 14,  0,255, 17,  0,
+    255, 20,  0,255, 24,  0,255, 27,  0,255, 31,  0,
+    255, 36,  0,255, 41,  0,255, 45,  0,255, 51,  0,
+    255, 57,  0,255, 63,  0,255, 70,  0,255, 77,  0,
+    255, 85,  0,255, 93,  0,255,102,  0,255,111,  0,
+    255,120,  0,255,130,  0,255,141,  0,255,152,  0,
+    255,164,  0,255,176,  0,255,188,  0,255,202,  0,
+    255,215,  0,255,230,  0,255,245,  0,250,255,  0,
+    235,255,  0,220,255,  0,206,255,  0,193,255,  0,
+    180,255,  0,168,255,  0,156,255,  0,145,255,  0,
+    134,255,  0,124,255,  0,114,255,  0,105,255,  0,
+     96,255,  0, 88,255,  0, 80,255,  0, 72,255,  0,
+     65,255,  0, 59,255,  0, 53,255,  0, 47,255,  0,
+     42,255,  0, 38,255,  0, 33,255,  0, 29,255,  0,
+     25,255,  0, 21,255,  0, 18,255,  0, 15,255,  0,
+     13,255,  0, 10,255,  0,  8,255,  0,  6,255,  0,
+      5,255,  0,  4,255,  0,  3,255,  0,  2,255,  0,
+      1,255,  0,  1,255,  0,  0,255,  0,  0,255,  0,
+      0,255,  0,  0,255,  0,  0,255,  0,  0,255,  0,
+      0,255,  0,  0,255,  0,  0,255,  1,  0,255,  1,
+      0,255,  2,  0,255,  3,  0,255,  4,  0,255,  5,
+      0,255,  7,  0,255,  9,  0,255, 11,  0,255, 13,
+      0,255, 16,  0,255, 19,  0,255, 22,  0,255, 26,
+      0,255, 30,  0,255, 34,  0,255, 39,  0,255, 43,
+      0,255, 49,  0,255, 55,  0,255, 61,  0,255, 68,
+      0,255, 75,  0,255, 82,  0,255, 90,  0,255, 99,
+      0,255,108,  0,255,117,  0,255,127,  0,255,137,
+      0,255,148,  0,255,160,  0,255,172,  0,255,184,
+      0,255,197,  0,255,211,  0,255,225,  0,255,240,
+      0,255,255,  0,240,255,  0,225,255,  0,211,255,
+      0,197,255,  0,184,255,  0,172,255,  0,160,255,
+      0,148,255,  0,137,255,  0,127,255,  0,117,255,
+      0,108,255,  0, 99,255,  0, 90,255,  0, 82,255,
+      0, 75,255,  0, 68,255,  0, 61,255,  0, 55,255,
+      0, 49,255,  0, 43,255,  0, 39,255,  0, 34,255,
+      0, 30,255,  0, 26,255,  0, 22,255,  0, 19,255,
+      0, 16,255,  0, 13,255,  0, 11,255,  0,  9,255,
+      0,  7,255,  0,  5,255,  0,  4,255,  0,  3,255,
+      0,  2,255,  0,  1,255,  0,  1,255,  0,  0,255,
+      0,  0,255,  0,  0,255,  0,  0,255,  0,  0,255,
+      0,  0,255,  0,  0,255,  0,  0,255,  1,  0,255,
+      1,  0,255,  2,  0,255,  3,  0,255,  4,  0,255,
+      5,  0,255,  6,  0,255,  8,  0,255, 10,  0,255,
+     13,  0,255, 15,  0,255, 18,  0,255, 21,  0,255,
+     25,  0,255, 29,  0,255, 33,  0,255, 38,  0,255,
+     42,  0,255, 47,  0,255, 53,  0,255, 59,  0,255,
+     65,  0,255, 72,  0,255, 80,  0,255, 88,  0,255,
+     96,  0,255,105,  0,255,114,  0,255,124,  0,255,
+    134,  0,255,145,  0,255,156,  0,255,168,  0,255,
+    180,  0,255,193,  0,255,206,  0,255,220,  0,255,
+    235,  0,255,250,  0,255,255,  0,245,255,  0,230,
+    255,  0,215,255,  0,202,255,  0,188,255,  0,176,
+    255,  0,164,255,  0,152,255,  0,141,255,  0,130,
+    255,  0,120,255,  0,111,255,  0,102,255,  0, 93,
+    255,  0, 85,255,  0, 77,255,  0, 70,255,  0, 63,
+    255,  0, 57,255,  0, 51,255,  0, 45,255,  0, 41,
+    255,  0, 36,255,  0, 31,255,  0, 27,255,  0, 24,
+    255,  0, 20,255,  0, 17,255,  0, 14,255,  0, 12,
+    255,  0, 10,255,  0,  8,255,  0,  6,255,  0,  5,
+    255,  0,  3,255,  0,  2,255,  0,  2,255,  0,  1,
+    255,  0,  1,255,  0,  0,255,  0,  0,255,  0,  0
+};
@@ -0,0 +1,24 @@
+/* File:      neo_pixel_tables.h
+ * Author:    Generated by scripts/gen-np-tables.py --gamma 2.6 --hue-size 256. Do not edit.
+ * Purpose:   Flash lookup tables for the NeoPixel library
+ */
+
+#ifndef NEOPIXEL_TABLES_H
+#define NEOPIXEL_TABLES_H
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+/****************************** DEFINES ******************************/
+#define NP_TABLE_GAMMA_X100       (260)
+#define NP_HUE_TABLE_SIZE         (256)
+// Table index for a 16-bit hue: floor(hue * NP_HUE_TABLE_SIZE / 65536)
+#define NP_HUE_TABLE_INDEX(h)     ((uint16_t)(h) >> 8)
+
+/*************************** FLASH CONSTANTS ***************************/
+extern const uint8_t PROGMEM _au8_NeoPixelSineTable[256];
+extern const uint8_t PROGMEM _au8_NeoPixelGammaTable[256];
+// R,G,B of each fully saturated hue, gamma corrected
+extern const uint8_t PROGMEM _au8_NeoPixelHueGammaTable[NP_HUE_TABLE_SIZE * 3];
+
+#endif /* NEOPIXEL_TABLES_H */
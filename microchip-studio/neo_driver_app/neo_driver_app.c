@@ -30,18 +30,52 @@
 /******************************** PROTOTYPES *********************************/
 static void randomize_anim();
 static void mode_logic();
+static void pix_adj_step(int8_t i8_step);
+static void pix_adj_exit();
+static bool frame_due();
+static void frame_idle_wait();
+#ifdef RTC_SCHED_EN
+static void rtc_update();
+static void rtc_add_msec(uint32_t u32_msec);
+static void rtc_save_runtime();
+static uint32_t rtc_msec_to_window();
+static void time_set_step(int8_t i8_step);
+static void time_set_draw();
+static void time_set_exit();
+#endif
+#ifdef FRAME_PWR_DOWN_EN
+static void frame_pwr_down_wait();
+#endif
 
 static void check_batt();
 
+#ifdef ENERGY_SCHED_EN
+static void energy_cycle_start(uint32_t u32_sleptMsec);
+static void energy_frame();
+static uint32_t energy_sleep_msec();
+static void energy_trend();
+#endif
+
 static void store_rand_seed();
 static void startup_seed_prng();
 
 static void enable_pc_ints();
 static void disable_pc_ints();
-static void shutdown();
-static void wd_enable(uint8_t u8_timeout);
+static uint32_t shutdown(uint32_t u32_msec);
+static uint32_t wd_sleep_msec(uint32_t u32_msec);
+static uint32_t wd_timeout_msec(uint8_t u8_timeout);
+static uint16_t wd_step_msec(uint8_t u8_step);
+static void wd_set_cal(uint16_t u16_calUsec);
+static void wd_calibrate();
 static void _wd_hw_enable(uint8_t u8_timeout);
 
+#ifdef DEBUG_COLOR_MATH_BENCH_EN
+static void debug_color_math_bench();
+#endif
+#ifdef DEBUG_MILLIS_DRIFT_EN
+static void debug_millis_drift();
+#endif
+
 // ISR's
 ISR(PCINT0_vect);
 ISR(WDT_vect);
@@ -51,20 +85,59 @@ ISR(WDT_vect);
 // If PROGMEM arrays are defined in the header file instead, they get placed in flash twice!
 // They can be declared in the header file, but should be defined in the .cpp/.c file.
 
+#ifdef RTC_SCHED_EN
+// Time set display, color of the current hour by quarter
+static const uint32_t au32_quarterColor[] PROGMEM = { COLOR_RED, COLOR_YELLOW, COLOR_GREEN, COLOR_BLUE };
+#endif
+
 /************************ GLOBAL RAM VARS DEFINITIONS ************************/
 
 // Shared with anim.c
 extern bool b_animReset;           // Used by mode logic to inform animations to reset
 extern bool b_animCycleComplete;   // Signal from animations to mode logic
 extern uint8_t u8_nextSleepTime;   // Data from terminating animations to mode logic
+extern uint16_t u16_nextFrameTime; // Data from animations to frame scheduler
+extern uint8_t u8_frameWdt;        // Data from animations to frame scheduler
 
 // Misc vars
 static uint8_t u8_anim = 0;                   // Index of current anim in table
 static uint8_t u8_mode = SYS_MODE_ANIM_SEL;   // Current mode
 static uint32_t u32_randSeed;
-static volatile uint8_t u8_wdtCounter = 0;    // Used by WDT code to handle multiple sleeps
 static volatile bool b_pinChangeWake = false; // Signal from pin change ISR to mode logic
+static volatile bool b_wdtFired = false;      // Signal from WDT ISR to wd_calibrate()
 static MULTIBUTTON_DATA_T s_leftBtn, s_rightBtn;
+static uint16_t u16_lastVccMv = 0;            // From the last check_batt()
+
+// Watchdog calibration, see wd_set_cal()
+static uint16_t u16_wdtCalUsec = WDT_CAL_NOMINAL_USEC;       // Measured usec per nominal 16 msec period
+static uint16_t u16_wdtStepQ6 = WDT_CAL_NOMINAL_USEC / 1000 * 64; // The same in 1/64 msec, for wd_step_msec()
+
+// Frame scheduler statistics, since power on
+static uint32_t u32_framesRendered = 0;       // Frames rendered and shown
+static uint32_t u32_idleWakes = 0;            // Idle sleep wake-ups from any source: deadline, Timer0 overflow, early match, switch
+#ifdef FRAME_PWR_DOWN_EN
+static uint32_t u32_framePwrDowns = 0;        // Watchdog power-down steps between frames
+#endif
+
+#ifdef RTC_SCHED_EN
+// Soft RTC
+static uint16_t u16_rtcMin = RTC_ON_START_MIN;  // Time of day, minutes after midnight
+static uint16_t u16_rtcMsec = 0;              // Into the current minute
+static uint32_t u32_rtcLastMs = 0;            // millis() at the last rtc_update()
+static uint16_t u16_runtimeMin = 0;           // Minutes not yet added to EEP_SETT_RUNTIME_MIN
+#endif
+
+#ifdef ENERGY_SCHED_EN
+// Energy budget sleep scheduler state
+static uint32_t u32_cycleStartMs = 0;         // millis() at the start of the anim cycle
+static uint32_t u32_levelMs = 0;              // Light level (np_get_level()) integrated over the cycle, level * msec
+static uint16_t u16_levelPrev = 0;            // Light level shown since the last frame
+static uint16_t u16_levelTime = 0;            // millis() of the last frame
+static uint32_t u32_runSec = 0;               // Time since power on, playing and asleep
+static uint32_t u32_trendStartSec = 0;        // Start of the Vcc trend window, in u32_runSec
+static uint16_t u16_trendStartMv = 0;         // Vcc at the start of the trend window, 0 before the first
+static uint8_t  u8_sleepGain = ENERGY_GAIN_ONE;   // Sleep scaling, corrected by the Vcc trend
+#endif
 
 // Array of animation "task" function pointers, in order of cycle
 static void (*apfn_renderFunc[])(void) = {
@@ -108,7 +181,9 @@ void setup() {
     bitSetMask( DIDR0, _BV(ADC2D) );                               // Disable digital input buffer on ADC2
     bitSetMask( PRR, _BV(PRTIM1) | _BV(PRUSI) );                   // Disable TIMER1, USI clocks
 
-    // Read EEPROM settings data -- Nothing to read currently.
+    // Read EEPROM settings data
+    np_set_length(eeprom_read_byte(EEP_SETT_NPIX));
+    draw_init();                                  // Matrix orientation
 
     // Update power-on counter
     inc_sat_eep_cntr_u16(EEP_SETT_NUM_POWER_ON);
@@ -118,10 +193,12 @@ void setup() {
     
     randomize_anim();
 
+    // Use the stored watchdog period, measure it now if there isn't one
+    wd_set_cal(eeprom_read_word(EEP_SETT_WDT_CAL));
+    if (u16_wdtCalUsec != eeprom_read_word(EEP_SETT_WDT_CAL)) { wd_calibrate(); }
+
     // Setup I/O
-    bitSetMask(DDRB, IO_NP_ENABLE);               // Set as o/p
-    bitSetMask(PORTB, IO_NP_ENABLE);              // Enable MOSFET for NeoPixel power
-    delay_msec(5);                                // Time for MOSFET to switch on
+    np_power_on();                                // Enable MOSFET for NeoPixel power, waits for it to switch on
     bitClearMask(DDRB, IO_SW_LEFT | IO_SW_RIGHT); // Set as i/p. TODO: This is the reset state, can we skip this?
     bitSetMask(PORTB, IO_SW_LEFT | IO_SW_RIGHT);  // Enable pull-ups
 
@@ -144,6 +221,14 @@ void setup() {
         }
     #endif
 
+    #ifdef DEBUG_COLOR_MATH_BENCH_EN
+        debug_color_math_bench();
+    #endif
+
+    #ifdef DEBUG_MILLIS_DRIFT_EN
+        debug_millis_drift();
+    #endif
+
     #ifdef DEBUG_RAND_SEED_EN
         draw_value_binary(u32_randSeed);
         np_show();
@@ -151,16 +236,28 @@ void setup() {
         soft_reset();
     #endif
     
+    #ifdef ENERGY_SCHED_EN
+    energy_cycle_start(0);
+    #endif
 
+    // Everything up to here ran at F_CPU. From now on only the transmit needs it.
+    clock_set(SYS_CLK_IDLE);
 }
 
 /********************************* MAIN LOOP *********************************/
 void loop() {
 
-    // Set brightness from potentiometer value
-    uint16_t u16_potVal = adc_read(IO_POT_ADC_CH, IO_POT_ADC_REF);
-    uint8_t u8_bright = np_get_gamma_8(map(u16_potVal, 0, 1023, BRIGHT_MIN, 255)); // Scale value
-    np_set_brightness(u8_bright);
+    // Set brightness from potentiometer value. The pot GND is switched with the NeoPixel power,
+    // keep the last brightness while that is gated off.
+    if (np_power_is_on()) {
+        uint16_t u16_potVal = adc_read(IO_POT_ADC_CH, IO_POT_ADC_REF);
+        uint8_t u8_bright = np_get_gamma_8(map(u16_potVal, 0, 1023, BRIGHT_MIN, 255)); // Scale value
+        np_set_brightness(u8_bright);
+    }
+
+    #ifdef RTC_SCHED_EN
+    rtc_update();
+    #endif
 
     // Monitor Vcc for low batt condition
     check_batt();
@@ -173,13 +270,37 @@ void loop() {
     mode_logic();
 
     if ( (u8_mode == SYS_MODE_ANIM_SEL) || (u8_mode == SYS_MODE_ANIM_SHUFF) ) {
-        (*apfn_renderFunc[u8_anim])();    // Render one frame in current anim
-        np_show();                        // and update the NeoPixels to show it
+        if (frame_due()) {
+            #ifdef CLK_PLL_EN
+            // Race to sleep: render and transmit at 16 MHz, if Vcc is high enough for it
+            if (u16_lastVccMv >= CLK_16MHZ_MIN_MV) { clock_set(CLK_SEL_16MHZ); }
+            #endif
+
+            u8_frameWdt = ANIM_FRAME_WDT_NONE;  // Animations with a coarse frame period opt in on each frame
+            (*apfn_renderFunc[u8_anim])();    // Render one frame in current anim
+            np_show();                        // and update the NeoPixels to show it
+            u32_framesRendered++;
+
+            #ifdef ENERGY_SCHED_EN
+            energy_frame();
+            #endif
+
+            #ifdef CLK_PLL_EN
+            clock_set(SYS_CLK_IDLE);          // Back down for idle, ADC and sleep
+            #endif
+        }
+        frame_idle_wait();
     }
     if (u8_mode == SYS_MODE_PIX_ADJ) {
-        np_fill_all(0xFF0000);
+        np_fill_all(0xFF0000);                // Light exactly the pixels in use
         np_show();
     }
+    #ifdef RTC_SCHED_EN
+    if (u8_mode == SYS_MODE_TIME_SET) {
+        time_set_draw();
+        np_show();
+    }
+    #endif
 
     #ifdef DEBUG_SOFT_RESET_ON_INTERVAL_EN
     if (millis() > (DEBUG_SOFT_RESET_INTERVAL_SEC * 1000))
@@ -203,6 +324,7 @@ static void randomize_anim() {
 
 static void mode_logic() {
     static uint8_t u8_animCycleCount = 0;
+    static uint8_t u8_wdtCalCount = 0;
 
     // Handle power down after an animation cycle
     if (b_animCycleComplete) {
@@ -212,8 +334,37 @@ static void mode_logic() {
         // We have completed an anim cycle, update the cycle counter in EEPROM
         inc_sat_eep_cntr_u16(EEP_SETT_NUM_CYCLES);
 
-        wd_enable(u8_nextSleepTime); // Value set by the terminating animation
-        shutdown();
+        // Value set by the terminating animation, or the energy scheduler
+        #ifdef ENERGY_SCHED_EN
+        energy_trend();
+        uint32_t u32_sleepMsec = energy_sleep_msec();
+        #else
+        uint32_t u32_sleepMsec = wd_timeout_msec(u8_nextSleepTime);
+        #endif
+
+        #ifdef RTC_SCHED_EN
+        // Outside the on-window, sleep through to its start
+        if (rtc_msec_to_window() > u32_sleepMsec) { u32_sleepMsec = rtc_msec_to_window(); }
+        #endif
+
+        // The WDT oscillator drifts with temperature and Vcc, measure it again now and then (with the strip dark)
+        if ((++u8_wdtCalCount & (WDT_CAL_CYCLES - 1)) == 0) {
+            np_clear();
+            np_show();
+            wd_calibrate();
+        }
+
+        uint32_t u32_sleptMsec = shutdown(u32_sleepMsec);
+
+        #ifdef RTC_SCHED_EN
+        rtc_add_msec(u32_sleptMsec);
+        #endif
+        #ifdef ENERGY_SCHED_EN
+        energy_cycle_start(u32_sleptMsec);
+        #endif
+        #if !defined(RTC_SCHED_EN) && !defined(ENERGY_SCHED_EN)
+        (void)u32_sleptMsec;
+        #endif
 
         // Don't randomize if we woke with switch
         if (u8_mode == SYS_MODE_ANIM_SHUFF && !b_pinChangeWake) {
@@ -251,6 +402,14 @@ static void mode_logic() {
             eeprom_update_byte(EEP_SETT_ANIM, u8_anim);
             store_rand_seed();
         }
+        else if (u8_mode == SYS_MODE_PIX_ADJ) {
+            pix_adj_step(-1);
+        }
+        #ifdef RTC_SCHED_EN
+        else if (u8_mode == SYS_MODE_TIME_SET) {
+            time_set_step(-1);
+        }
+        #endif
 
         break;
     // Left Double Click
@@ -285,9 +444,53 @@ static void mode_logic() {
             anim_blk_flash_chars("PWR-CNT");
             anim_blk_print_dec_u32((uint32_t)(u16_val));
 
+            anim_blk_flash_chars("FRM-CNT");
+            anim_blk_print_dec_u32(u32_framesRendered);
+
+            anim_blk_flash_chars("WAK-CNT");
+            anim_blk_print_dec_u32(u32_idleWakes);
+
+            #ifdef FRAME_PWR_DOWN_EN
+            anim_blk_flash_chars("PWD-CNT");
+            anim_blk_print_dec_u32(u32_framePwrDowns);
+            #endif
+
+            // Sample the show stats first, the stats print itself calls show()
+            uint32_t u32_showCnt = np_get_show_count();
+            uint32_t u32_skipCnt = np_get_skip_count();
+            #ifdef DRAW_GLYPH_CACHE_EN
+            uint32_t u32_glyphHit = draw_get_glyph_hit_count();   // Likewise, the stats print draws glyphs
+            uint32_t u32_glyphMiss = draw_get_glyph_miss_count();
+            #endif
+
+            anim_blk_flash_chars("TX-CNT");
+            anim_blk_print_dec_u32(u32_showCnt);
+
+            anim_blk_flash_chars("TX-SKP");
+            anim_blk_print_dec_u32(u32_skipCnt);
+
+            #ifdef DRAW_GLYPH_CACHE_EN
+            anim_blk_flash_chars("GLY-HIT");
+            anim_blk_print_dec_u32(u32_glyphHit);
+
+            anim_blk_flash_chars("GLY-MIS");
+            anim_blk_print_dec_u32(u32_glyphMiss);
+            #endif
+
+            #ifdef RTC_SCHED_EN
+            u16_val = eeprom_read_word(EEP_SETT_RUNTIME_MIN);
+            anim_blk_flash_chars("RUN-MIN");
+            anim_blk_print_dec_u32((uint32_t)(u16_val));
+            #endif
+
             // Return to usual mode
-            u8_mode = SYS_MODE_ANIM_SEL;
+            pix_adj_exit();
         }
+        #ifdef RTC_SCHED_EN
+        else if (u8_mode == SYS_MODE_TIME_SET) {
+            time_set_exit();
+        }
+        #endif
 
 
         break;
@@ -312,6 +515,14 @@ static void mode_logic() {
             eeprom_update_byte(EEP_SETT_ANIM, u8_anim);
             store_rand_seed();
         }
+        else if (u8_mode == SYS_MODE_PIX_ADJ) {
+            pix_adj_step(1);
+        }
+        #ifdef RTC_SCHED_EN
+        else if (u8_mode == SYS_MODE_TIME_SET) {
+            time_set_step(1);
+        }
+        #endif
 
         break;
     // Right Double Click
@@ -328,23 +539,236 @@ static void mode_logic() {
             u8_mode = SYS_MODE_PIX_ADJ;
         }
         else if (u8_mode == SYS_MODE_PIX_ADJ) {
-            u8_mode = SYS_MODE_ANIM_SEL;
+            pix_adj_exit();
+            #ifdef RTC_SCHED_EN
+            u8_mode = SYS_MODE_TIME_SET;          // Setup continues with the time of day
+            #endif
+        }
+        #ifdef RTC_SCHED_EN
+        else if (u8_mode == SYS_MODE_TIME_SET) {
+            time_set_exit();
         }
+        #endif
 
         break;
     }
 }
 
+// Grow or shrink the pixel count by one, between 1 and NP_PIXEL_COUNT_MAX
+static void pix_adj_step(int8_t i8_step) {
+    uint8_t u8_numPixels = np_get_length();
+
+    if (i8_step < 0) {
+        if (u8_numPixels == 1) { return; }
+
+        // Turn off the pixel being dropped, it won't be sent anymore
+        np_set_pix_color(u8_numPixels - 1, 0, 0, 0);
+        np_show();
+        u8_numPixels--;
+    } else {
+        if (u8_numPixels == NP_PIXEL_COUNT_MAX) { return; }
+        u8_numPixels++;
+    }
+
+    np_set_length(u8_numPixels);
+}
+
+// Save the pixel count and return to the usual mode
+static void pix_adj_exit() {
+    eeprom_update_byte(EEP_SETT_NPIX, np_get_length());
+
+    np_clear();
+    u8_mode = SYS_MODE_ANIM_SEL;
+    b_animReset = true;
+}
+
+/****************************** FRAME SCHEDULER ******************************/
+
+// Is the frame deadline declared by the current anim reached? A reset always renders right away.
+static bool frame_due() {
+
+    return b_animReset || ((int16_t)((uint16_t)millis() - u16_nextFrameTime) >= 0);
+}
+
+// Sit in idle sleep until the next frame deadline, or until a switch changes state.
+// Timer0 keeps running in idle, so millis() advances. Its compare match is armed for the deadline, and its overflow
+// (every 2 msec, or 32.8 msec tickless) wakes us to re-arm it.
+static void frame_idle_wait() {
+
+    // Mode logic has work to do right away
+    if (b_animCycleComplete || b_animReset) { return; }
+
+    // Hold events are timed by polling, so don't sleep while a switch is down
+    if ( (!bitReadMask(PINB, IO_SW_LEFT)) || (!bitReadMask(PINB, IO_SW_RIGHT)) ) { return; }
+
+    #ifdef NP_PWR_GATE_EN
+    // The strip stays black at least until the next frame. Cut the pixels' quiescent current if that is long
+    // enough to pay for the restart. np_show() powers them back up for the first lit frame.
+    if (np_is_dark() && ((int16_t)(u16_nextFrameTime - (uint16_t)millis()) >= NP_PWR_GATE_MIN_MSEC)) {
+        np_power_off();
+    }
+    #endif
+
+    enable_pc_ints();                      // Wake-up Source
+
+    #ifdef FRAME_PWR_DOWN_EN
+    if (u8_frameWdt != ANIM_FRAME_WDT_NONE) { frame_pwr_down_wait(); }
+    #endif
+
+    // Idle through the rest, shorter than the smallest watchdog step
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_enable();
+
+    while (!frame_due() && !b_pinChangeWake) {
+        cli();
+        timer0_wake_at(u16_nextFrameTime);
+        sei();
+        sleep_cpu();                       // sei() holds off interrupts for one instruction, so no wake-up is missed
+        // Exec Timer0 or PC ISR, then return here
+
+        u32_idleWakes++;
+    }
+
+    sleep_disable();
+    disable_pc_ints();                     // Don't want these during normal operation
+
+    // This flag is only meaningful to the mode logic after a shutdown()
+    b_pinChangeWake = false;
+}
+
+#ifdef FRAME_PWR_DOWN_EN
+// Power down in watchdog steps until the frame deadline is closer than the smallest step (16 msec), or until a
+// switch changes state. Timer0 is stopped in power-down, so millis() is advanced by each step instead.
+// Steps are the calibrated WDT periods (wd_step_msec()). Pin change wakes are mid-step, those are assumed to be
+// half way through.
+static void frame_pwr_down_wait() {
+    uint8_t u8_step = u8_frameWdt;
+    int16_t i16_remain;
+
+    ADCSRA &= ~(_BV(ADEN));                // The ADC would keep drawing current in power-down
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+    sleep_enable();
+
+    while (!b_pinChangeWake) {
+        i16_remain = (int16_t)(u16_nextFrameTime - (uint16_t)millis());
+
+        // Largest step that still fits before the deadline
+        while ((u8_step > WDT_16MS) && (i16_remain < (int16_t)wd_step_msec(u8_step))) { u8_step--; }
+        if (i16_remain < (int16_t)wd_step_msec(u8_step)) { break; }
+
+        _wd_hw_enable(u8_step);
+        sleep_cpu();
+        // Exec WDT or PC ISR, then return here
+
+        if (b_pinChangeWake) {
+            bitClear(WDTCR, WDIE);         // Stop the watchdog, the step was cut short
+            millis_advance(wd_step_msec(u8_step) / 2);
+        } else {
+            millis_advance(wd_step_msec(u8_step));
+        }
+        u32_framePwrDowns++;
+    }
+
+    sleep_disable();
+    ADCSRA |= _BV(ADEN);                   // Enable ADC
+}
+#endif
+
+#ifdef RTC_SCHED_EN
+/********************************* SOFT RTC **********************************/
+
+// Count the time millis() has advanced by since the last call. Blocking anims (stats print) can run for a minute.
+static void rtc_update() {
+    uint32_t u32_now = millis();
+
+    rtc_add_msec(u32_now - u32_rtcLastMs);
+    u32_rtcLastMs = u32_now;
+}
+
+// Advance the clock, by millis() time or by a sleep that Timer0 did not count
+static void rtc_add_msec(uint32_t u32_msec) {
+
+    uint32_t u32_min;
+
+    u32_msec += u16_rtcMsec;
+
+    // No division for the usual few msec. Long sleeps take one divide for all their minutes.
+    if (u32_msec < 60000) {
+        u16_rtcMsec = u32_msec;
+        return;
+    }
+    u32_min = u32_msec / 60000;
+    u16_rtcMsec = u32_msec % 60000;                 // Same divide call as the line above
+
+    u16_rtcMin = (u16_rtcMin + (uint16_t)(u32_min % RTC_MIN_PER_DAY)) % RTC_MIN_PER_DAY;
+
+    // One EEPROM write per call, however many minutes it counts
+    u16_runtimeMin = ((uint32_t)(0xFFFF - u16_runtimeMin) < u32_min) ? 0xFFFF : (u16_runtimeMin + (uint16_t)u32_min);
+    if (u16_runtimeMin >= RTC_RUNTIME_SAVE_MIN) { rtc_save_runtime(); }
+}
+
+// Add the minutes counted so far to the runtime in EEPROM. Blank (0xFFFF) starts from 0, a full counter saturates.
+// Stops counting once the battery is dead, check_batt() clears it when charged again.
+static void rtc_save_runtime() {
+    uint16_t u16_runMin = eeprom_read_word(EEP_SETT_RUNTIME_MIN);
+
+    if (!bitReadMask(eeprom_read_byte(EEP_SETT_FLAGS), STAT_FLG_BATT_DEAD)) {
+        if (u16_runMin == 0xFFFF) { u16_runMin = 0; }
+        u16_runMin = ((uint16_t)(0xFFFE - u16_runMin) < u16_runtimeMin) ? 0xFFFE : u16_runMin + u16_runtimeMin;
+        eeprom_update_word(EEP_SETT_RUNTIME_MIN, u16_runMin);
+    }
+    u16_runtimeMin = 0;
+}
+
+// Time until the daily on-window opens (msec), 0 while it is open
+static uint32_t rtc_msec_to_window() {
+    uint16_t u16_sinceStart = (u16_rtcMin + RTC_MIN_PER_DAY - RTC_ON_START_MIN) % RTC_MIN_PER_DAY;
+
+    if (u16_sinceStart < RTC_ON_WINDOW_MIN) { return 0; }
+
+    return (uint32_t)(RTC_MIN_PER_DAY - u16_sinceStart) * 60000 - u16_rtcMsec;
+}
+
+// Move the time of day by one RTC_SET_STEP_MIN step, rounded to the step and wrapping around midnight
+static void time_set_step(int8_t i8_step) {
+
+    u16_rtcMin -= u16_rtcMin % RTC_SET_STEP_MIN;
+    if (i8_step < 0) { u16_rtcMin = (u16_rtcMin ? u16_rtcMin : RTC_MIN_PER_DAY) - RTC_SET_STEP_MIN; }
+    else             { u16_rtcMin = (u16_rtcMin + RTC_SET_STEP_MIN) % RTC_MIN_PER_DAY; }
+    u16_rtcMsec = 0;
+}
+
+// One pixel per hour, lit up to the current one. The current hour's color gives the quarter: red :00, yellow :15,
+// green :30, blue :45. With fewer than 24 pixels the hours are scaled to the strip, so some hours share a pixel.
+static void time_set_draw() {
+    uint8_t u8_pos = u16_rtcMin / 60;
+    uint8_t u8_numPix = np_get_length();
+
+    if (u8_numPix < 24) { u8_pos = (uint16_t)u8_pos * u8_numPix / 24; }
+
+    np_clear();
+    if (u8_pos) { np_fill(COLOR_PURPLE, 0, u8_pos); }
+    np_set_pix_color_pack(u8_pos, pgm_read_dword(&au32_quarterColor[(u16_rtcMin % 60) / 15]));
+}
+
+// Show the time set as HHMM and return to the usual mode
+static void time_set_exit() {
+
+    anim_blk_print_dec_u32((uint32_t)(u16_rtcMin / 60) * 100 + (u16_rtcMin % 60));
+
+    np_clear();
+    u8_mode = SYS_MODE_ANIM_SEL;
+    b_animReset = true;
+}
+#endif
+
 /*********************************** ISR's ***********************************/
 
 // Left or Right Switch
 ISR(PCINT0_vect) {
 
-    // Signal to mode logic
+    // Signal to mode logic. If we woke up with a switch, we don't want any additional WDT sleeps.
     b_pinChangeWake = true;
-
-    // If we woke up with a switch, we don't want any additional WDT sleeps.
-    u8_wdtCounter = 0;
 }
 
 // Watchdog timer
@@ -352,6 +776,8 @@ ISR(WDT_vect) {
 
     // Disable WDT interrupt
     bitClear(WDTCR, WDIE);
+
+    b_wdtFired = true;
 }
 
 /***************************** SUPPORT FUNCTIONS *****************************/
@@ -365,6 +791,8 @@ static void check_batt() {
     uint8_t u8_statusFlags;
     bool b_shutdown = false;
 
+    u16_lastVccMv = u16_batt_mv;
+
     u8_statusFlags = eeprom_read_byte(EEP_SETT_FLAGS);
 
     // Has the low battery condition been previously detected?
@@ -377,6 +805,10 @@ static void check_batt() {
             bitClearMask(u8_statusFlags, STAT_FLG_BATT_DEAD);
             eeprom_update_byte(EEP_SETT_FLAGS, u8_statusFlags);
 
+            #ifdef RTC_SCHED_EN
+            eeprom_update_word(EEP_SETT_RUNTIME_MIN, 0);  // Runtime since last charge
+            #endif
+
         } else {
             // Shutdown
             b_shutdown = true;
@@ -409,7 +841,7 @@ static void check_batt() {
         eeprom_update_byte(EEP_SETT_FLAGS, u8_statusFlags);
 
         anim_blk_low_batt();
-        shutdown();
+        shutdown(0);                 // Until a switch wakes us
 
         u16_onTimeAcc = u16_lastScan = 0; // Timer Reset
     }
@@ -417,6 +849,88 @@ static void check_batt() {
 
 }
 
+#ifdef ENERGY_SCHED_EN
+// Start accounting a new anim cycle. Counts the sleep before it, as far as it went.
+static void energy_cycle_start(uint32_t u32_sleptMsec) {
+
+    u32_runSec += (u32_sleptMsec + 500) / 1000;
+
+    u32_cycleStartMs = millis();
+    u32_levelMs = 0;
+    u16_levelPrev = np_get_level();
+    u16_levelTime = (uint16_t)u32_cycleStartMs;
+}
+
+// Integrate the light level of the frame that was up until now, then start on the new one
+static void energy_frame() {
+    uint16_t u16_now = millis();
+
+    uint32_t u32_add = (uint32_t)u16_levelPrev * (uint16_t)(u16_now - u16_levelTime);
+
+    // Saturate, a bright frame held for a few minutes would overflow it
+    u32_levelMs = (u32_levelMs > (UINT32_MAX - u32_add)) ? UINT32_MAX : (u32_levelMs + u32_add);
+    u16_levelPrev = np_get_level();
+    u16_levelTime = u16_now;
+}
+
+// Estimate the charge the cycle used, and return the sleep (msec) that brings the average current of the cycle and
+// the sleep after it down to ENERGY_TARGET_UA: Q = I_target * t_on + (I_target - I_sleep) * t_sleep
+static uint32_t energy_sleep_msec() {
+    uint32_t u32_onMs = millis() - u32_cycleStartMs;
+    uint32_t u32_qUc, u32_budgetUc, u32_sleepMs = 0, u32_overUc;
+
+    energy_frame();
+    u32_runSec += (u32_onMs + 500) / 1000;
+
+    // uA * msec / 1000 = uC. nA * msec / 1000000 = uC. Whole seconds first: the setup modes keep the cycle running,
+    // and u32_onMs * ENERGY_ON_UA would overflow after 715 sec. This way it holds for days, longer than the cell lasts.
+    u32_qUc = (u32_onMs / 1000) * ENERGY_ON_UA + (u32_onMs % 1000) * ENERGY_ON_UA / 1000
+            + (u32_levelMs / 1000) * ENERGY_LED_NA_PER_LEVEL / 1000;
+    u32_budgetUc = (u32_onMs / 1000) * ENERGY_TARGET_UA + (u32_onMs % 1000) * ENERGY_TARGET_UA / 1000;
+
+    // uC / uA = sec, in msec for wd_sleep_msec(). Whole seconds first, so the overdraw * 1000 can't overflow.
+    if (u32_qUc > u32_budgetUc) {
+        u32_overUc = u32_qUc - u32_budgetUc;
+        u32_sleepMs = (u32_overUc / (ENERGY_TARGET_UA - ENERGY_SLEEP_UA)) * 1000
+                    + (u32_overUc % (ENERGY_TARGET_UA - ENERGY_SLEEP_UA)) * 1000 / (ENERGY_TARGET_UA - ENERGY_SLEEP_UA);
+    }
+    u32_sleepMs = (u32_sleepMs / ENERGY_GAIN_ONE) * u8_sleepGain;
+
+    // Always rest a little between cycles
+    if (u32_sleepMs < WDT_MSEC(WDT_1S)) { u32_sleepMs = WDT_MSEC(WDT_1S); }
+
+    return u32_sleepMs;
+}
+
+// Compare the Vcc drop over the last trend window with the runtime target. Sleep more if the cell would reach the
+// cutoff early, less if it is well ahead. The LiFePO4 curve is flat for most of the charge, so this mostly acts
+// near the end of it, and ENERGY_BATT_CAP_MAH sets the pace until then.
+static void energy_trend() {
+    uint16_t u16_mv = u16_lastVccMv;
+    uint32_t u32_windowSec = u32_runSec - u32_trendStartSec;
+
+    if (u16_trendStartMv && (u32_windowSec < ENERGY_TREND_WINDOW_SEC)) { return; }
+
+    if (u16_trendStartMv && (u16_mv < u16_trendStartMv) && (u16_mv > BATT_DISCHG_THRESH_MV)) {
+        // Time to the cutoff at this window's rate, and time left to the target
+        uint32_t u32_toCutoffSec = (uint32_t)(u16_mv - BATT_DISCHG_THRESH_MV) * u32_windowSec / (u16_trendStartMv - u16_mv);
+        uint32_t u32_leftSec = (u32_runSec < ENERGY_TARGET_SEC) ? (ENERGY_TARGET_SEC - u32_runSec) : 0;
+
+        if (u32_toCutoffSec < u32_leftSec) {
+            u8_sleepGain = ((uint16_t)u8_sleepGain + (u8_sleepGain / 8) > ENERGY_GAIN_MAX) ? ENERGY_GAIN_MAX
+                                                                                          : u8_sleepGain + (u8_sleepGain / 8);
+        } else if (u32_toCutoffSec > (u32_leftSec + (u32_leftSec / 2))) {
+            u8_sleepGain -= u8_sleepGain / 16;
+            if (u8_sleepGain < ENERGY_GAIN_MIN) { u8_sleepGain = ENERGY_GAIN_MIN; }
+        }
+    }
+
+    // Start the next window
+    u16_trendStartMv = u16_mv;
+    u32_trendStartSec = u32_runSec;
+}
+#endif
+
 static void enable_pc_ints() {
 
     GIMSK |= _BV(PCIE);                 // Enable Pin Change Interrupts
@@ -429,70 +943,135 @@ static void disable_pc_ints() {
     GIMSK &= ~(_BV(PCIE));              // Disable Pin Change Interrupts
 }
 
-// Turn off LEDs and send ATtiny to sleep, waiting for interrupt (WDT or pin change) to wake
-static void shutdown() {
+// Turn off LEDs and send ATtiny to sleep for u32_msec, or until a switch changes state. 0 sleeps until a switch
+// wakes us. Returns the time slept (msec).
+static uint32_t shutdown(uint32_t u32_msec) {
+    uint32_t u32_sleptMsec = 0;
 
     np_clear();
     np_show();
 
     //DIDR0 |= (_BV(ADC2D));               // Disable digital input buffer for ADC2
-    bitClearMask(DDRB, IO_NP_DATA          // Hi-Z to save power
-                      |IO_NP_ENABLE);      // Hi-Z to turn off MOSFET
-    bitSetMask(PORTB, IO_NP_DATA);         // Pull-up
-    bitClearMask(PORTB, IO_NP_ENABLE);     // No Pull-up, there is external pull-down
+    np_power_off();                        // Turn off MOSFET, data line Hi-Z
 
     ADCSRA &= ~(_BV(ADEN));                // Disable ADC
 
+    b_pinChangeWake = false;
     enable_pc_ints();                      // Wake-up Source
     set_sleep_mode(SLEEP_MODE_PWR_DOWN);
     sleep_enable();
 
-    //sleep_bod_disable();                 // ATtiny85 Revision C or newer only
-    sei();                                 // Global Interrupt Enable
-    sleep_cpu();
-    // Exec PC or WDT ISR, then return here
-
-    // Handle additional WDT sleeps, if needed
-    while (u8_wdtCounter > 0) {
-
-        _wd_hw_enable(WDT_8S);
-        //sleep_bod_disable();             // ATtiny85 Revision C or newer only
-        sei();                             // Global Interrupt Enable
-        sleep_cpu();
-        // Exec PC or WDT ISR, then return here
-
-        // Counter will be set to 0 if we woke by pin change.
-        if (u8_wdtCounter == 0) { break; }
-
-        u8_wdtCounter--;
+    if (u32_msec) {
+        u32_sleptMsec = wd_sleep_msec(u32_msec);
+    } else {
+        while (!b_pinChangeWake) {
+            //sleep_bod_disable();         // ATtiny85 Revision C or newer only
+            sei();                         // Global Interrupt Enable
+            sleep_cpu();
+            // Exec PC ISR, then return here
+        }
     }
     
     sleep_disable();
     disable_pc_ints();                     // Don't want these during normal operation
 
-    bitSetMask(DDRB, IO_NP_DATA            // Restore for NeoPixel Lib
-                    |IO_NP_ENABLE);
-    bitSetMask(PORTB, IO_NP_ENABLE);       // Enable power for NeoPixels
+    np_power_on();                         // Enable power for NeoPixels, resend everything on next show
     ADCSRA |= _BV(ADEN);                   // Enable ADC
 
     // Reset the button state machines
     mb_reset(&s_leftBtn);
     mb_reset(&s_rightBtn);
+
+    return u32_sleptMsec;
 }
 
+// Sleep for u32_msec in the current sleep mode, composed from the watchdog steps, largest first. The steps are
+// taken at their calibrated length, the remainder below the 16 msec step is dropped. Stops early if a switch
+// changes state, counting the cut step as half slept. Returns the time slept (msec).
+static uint32_t wd_sleep_msec(uint32_t u32_msec) {
+    uint32_t u32_sleptMsec = 0;
+    uint8_t u8_step = WDT_8S;
+    uint16_t u16_stepMsec;
 
-// External interface for WDT. Call with one of the WDT_XXX constants. Sets up WDT software and hardware.
-static void wd_enable(uint8_t u8_timeout) {
+    while (!b_pinChangeWake) {
 
-    // Setup our software counter.
-    if (u8_timeout > WDT_8S) {
-        u8_wdtCounter = u8_timeout - WDT_8S; // Calculate 8 second repeat count
-        u8_timeout = WDT_8S;                 // Set hardware for 8 seconds
-    } else {
-        u8_wdtCounter = 0;
+        // Largest step that still fits in the remaining time
+        while ((u8_step > WDT_16MS) && (wd_step_msec(u8_step) > u32_msec)) { u8_step--; }
+        u16_stepMsec = wd_step_msec(u8_step);
+        if (u16_stepMsec > u32_msec) { break; }
+
+        _wd_hw_enable(u8_step);
+        //sleep_bod_disable();             // ATtiny85 Revision C or newer only
+        sei();                             // Global Interrupt Enable
+        sleep_cpu();
+        // Exec PC or WDT ISR, then return here
+
+        if (b_pinChangeWake) {
+            bitClear(WDTCR, WDIE);         // Stop the watchdog, the step was cut short
+            u16_stepMsec /= 2;
+        }
+        u32_sleptMsec += u16_stepMsec;
+        u32_msec -= u16_stepMsec;
     }
 
-    _wd_hw_enable(u8_timeout);
+    return u32_sleptMsec;
+}
+
+// Nominal length (msec) of a WDT_XXX timeout, including the software generated multiples of 8 sec
+static uint32_t wd_timeout_msec(uint8_t u8_timeout) {
+
+    if (u8_timeout > WDT_8S) { return (uint32_t)(u8_timeout - WDT_8S + 1) * WDT_MSEC(WDT_8S); }
+    return WDT_MSEC(u8_timeout);
+}
+
+// Calibrated length (msec) of a hardware step, WDT_16MS to WDT_8S. Shifts only, cheap enough for the frame scheduler.
+static uint16_t wd_step_msec(uint8_t u8_step) {
+
+    return (uint16_t)(((uint32_t)u16_wdtStepQ6 << u8_step) >> 6);
+}
+
+// Set the measured watchdog period (usec per nominal 16 msec), falling back to nominal if out of range
+static void wd_set_cal(uint16_t u16_calUsec) {
+
+    if ((u16_calUsec < WDT_CAL_MIN_USEC) || (u16_calUsec > WDT_CAL_MAX_USEC)) { u16_calUsec = WDT_CAL_NOMINAL_USEC; }
+
+    u16_wdtCalUsec = u16_calUsec;
+    u16_wdtStepQ6 = ((uint32_t)u16_calUsec * 64 + 500) / 1000;
+}
+
+// Measure the watchdog period against Timer0, which keeps running in idle sleep. Takes one WDT_CAL_STEP (~250 msec).
+// The WDT prescaler restarts with wdt_reset(), so the step starts within one 128 kHz cycle of the micros() stamp.
+// The result is stored in EEPROM if it moved by more than 1/WDT_CAL_DRIFT_DIV.
+static void wd_calibrate() {
+    uint32_t u32_startUsec, u32_usec;
+    uint16_t u16_calUsec = u16_wdtCalUsec;
+
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_enable();
+
+    cli();
+    b_wdtFired = false;
+    _wd_hw_enable(WDT_CAL_STEP);
+    u32_startUsec = micros();
+    while (!b_wdtFired) {
+        sei();
+        sleep_cpu();                       // sei() holds off interrupts for one instruction, so no wake-up is missed
+        // Exec Timer0 or WDT ISR, then return here
+        cli();
+    }
+    u32_usec = micros() - u32_startUsec;
+    sei();
+
+    sleep_disable();
+
+    wd_set_cal((uint16_t)(u32_usec >> WDT_CAL_STEP));
+
+    // Spare the EEPROM small changes
+    if ((u16_wdtCalUsec > u16_calUsec + u16_calUsec / WDT_CAL_DRIFT_DIV) ||
+        (u16_wdtCalUsec < u16_calUsec - u16_calUsec / WDT_CAL_DRIFT_DIV) ||
+        (eeprom_read_word(EEP_SETT_WDT_CAL) != u16_calUsec)) {
+        eeprom_update_word(EEP_SETT_WDT_CAL, u16_wdtCalUsec);
+    }
 }
 
 // Sets up WDT hardware. Enable WDT interrupt and set prescale value.
@@ -540,4 +1119,130 @@ static void startup_seed_prng() {
 
 }
 
+/****************************** DEBUG FUNCTIONS ******************************/
+
+#ifdef DEBUG_COLOR_MATH_BENCH_EN
+
+#define BENCH_ITERATIONS (64)
+
+// Reference HSV conversion using the multiplies of the original Adafruit code
+static uint32_t bench_hsv_to_pack_mul(uint16_t u16_hue, uint8_t u8_sat, uint8_t u8_val) {
+    uint8_t u8_red, u8_green, u8_blue;
+
+    u16_hue = (u16_hue * 1530L + 32768) / 65536;
+    if      (u16_hue < 255)  { u8_red = 255;            u8_green = u16_hue;        u8_blue = 0; }
+    else if (u16_hue < 510)  { u8_red = 510 - u16_hue;  u8_green = 255;            u8_blue = 0; }
+    else if (u16_hue < 765)  { u8_red = 0;              u8_green = 255;            u8_blue = u16_hue - 510; }
+    else if (u16_hue < 1020) { u8_red = 0;              u8_green = 1020 - u16_hue; u8_blue = 255; }
+    else if (u16_hue < 1275) { u8_red = u16_hue - 1020; u8_green = 0;              u8_blue = 255; }
+    else if (u16_hue < 1530) { u8_red = 255;            u8_green = 0;              u8_blue = 1530 - u16_hue; }
+    else                     { u8_red = 255;            u8_green = 0;              u8_blue = 0; }
+
+    uint32_t u32_valPlus1 =   1 + u8_val;
+    uint16_t u16_satPlus1 =   1 + u8_sat;
+    uint8_t  u8_satInvert = 255 - u8_sat;
+
+    return ((((((u8_red   * u16_satPlus1) >> 8) + u8_satInvert) * u32_valPlus1) & 0xff00)  << 8)  |
+            (((((u8_green * u16_satPlus1) >> 8) + u8_satInvert) * u32_valPlus1) & 0xff00)         |
+            (((((u8_blue  * u16_satPlus1) >> 8) + u8_satInvert) * u32_valPlus1)            >> 8);
+}
+
+// Reference fill, scaling the color with multiplies for every pixel
+static void bench_fill_mul(uint32_t u32_color, uint8_t u8_bright) {
+    for (uint8_t u8_pixIdx = 0; u8_pixIdx < np_get_length(); u8_pixIdx++) {
+        np_set_pix_color(u8_pixIdx, ((uint8_t)(u32_color >> 16) * u8_bright) >> 8,
+                                    ((uint8_t)(u32_color >>  8) * u8_bright) >> 8,
+                                    ((uint8_t)(u32_color >>  0) * u8_bright) >> 8);
+    }
+}
+
+// Print the average cycles per call of the reference (multiply) and current color math, on the LEDs.
+// Includes the loop overhead and the Timer0 ISR, so compare the pairs rather than the absolute values.
+static void debug_color_math_bench() {
+    volatile uint32_t u32_sink;
+    uint32_t u32_start;
+    uint16_t u16_i;
+
+    u32_start = micros();
+    for (u16_i = 0; u16_i < BENCH_ITERATIONS; u16_i++) { u32_sink = bench_hsv_to_pack_mul(u16_i * 1021, 200, 150); }
+    uint32_t u32_hsvMul = (micros() - u32_start) * clockCyclesPerMicrosecond() / BENCH_ITERATIONS;
+
+    u32_start = micros();
+    for (u16_i = 0; u16_i < BENCH_ITERATIONS; u16_i++) { u32_sink = np_hsv_to_pack(u16_i * 1021, 200, 150); }
+    uint32_t u32_hsvSft = (micros() - u32_start) * clockCyclesPerMicrosecond() / BENCH_ITERATIONS;
+
+    u32_start = micros();
+    for (u16_i = 0; u16_i < BENCH_ITERATIONS; u16_i++) { bench_fill_mul(u16_i * 0x010203UL, 100); }
+    uint32_t u32_fillMul = (micros() - u32_start) * clockCyclesPerMicrosecond() / BENCH_ITERATIONS;
+
+    u32_start = micros();
+    for (u16_i = 0; u16_i < BENCH_ITERATIONS; u16_i++) { np_fill_all(u16_i * 0x010203UL); }
+    uint32_t u32_fillSft = (micros() - u32_start) * clockCyclesPerMicrosecond() / BENCH_ITERATIONS;
+    (void)u32_sink;
+
+    anim_blk_flash_chars("HSV-MUL");
+    anim_blk_print_dec_u32(u32_hsvMul);
+    anim_blk_flash_chars("HSV");
+    anim_blk_print_dec_u32(u32_hsvSft);
+    anim_blk_flash_chars("FILL-MUL");
+    anim_blk_print_dec_u32(u32_fillMul);
+    anim_blk_flash_chars("FILL");
+    anim_blk_print_dec_u32(u32_fillSft);
+}
+
+#endif /* DEBUG_COLOR_MATH_BENCH_EN */
+
+#ifdef DEBUG_MILLIS_DRIFT_EN
+
+#ifdef TIMER0_TICKLESS_EN
+  #error "DEBUG_MILLIS_DRIFT_EN requires TIMER0_TICKLESS_EN undefined"
+#endif
+
+#define DRIFT_TEST_MSEC     (10000)  // Length of the test, by the reference clock
+#define DRIFT_SHADER_USEC   (100)    // Added to each pixel gap: 25 * (30 + 100) usec = 3.3 msec per transmit
+
+// Slow shader, so every transmit spans at least one Timer0 overflow (2.048 msec). The long gaps may
+// latch the pixels early, the display is not what is being tested.
+static uint32_t debug_drift_shader(uint8_t u8_pixIdx) {
+    delay_usec(DRIFT_SHADER_USEC);
+    return (u8_pixIdx & 1) ? 0x000010UL : 0;
+}
+
+// Measure the time millis() loses over back-to-back transmits, and print it on the LEDs (LOST-MS).
+// Timer1 is the reference: same clock as Timer0, but counted in hardware with no interrupt involved.
+// Build with and without NP_SHOW_ISR_WINDOW_EN to compare. Resolution is a few msec.
+// Only valid with TIMER0_TICKLESS_EN undefined: the test relies on each transmit spanning a 2.048 msec
+// overflow, and tickless overflows are 32.768 msec apart, so most transmits would not span one.
+static void debug_millis_drift() {
+    uint32_t u32_refTicks = 0;
+    uint8_t  u8_refLast;
+    uint8_t  u8_refNow;
+
+    bitClearMask(PRR, _BV(PRTIM1));                               // Enable TIMER1 clock
+    TCCR1 = _BV(CS13) | _BV(CS12) | _BV(CS11) | _BV(CS10);        // CK/16384: 2.048 msec per tick, wraps every 524 msec
+    u8_refLast = TCNT1;
+    uint32_t u32_startTime = millis();
+
+    // Sample Timer1 after every transmit, well before it wraps
+    while ((u32_refTicks * 2048 / 1000) < DRIFT_TEST_MSEC) {
+        np_set_shader(debug_drift_shader);
+        np_show();
+
+        u8_refNow = TCNT1;
+        u32_refTicks += (uint8_t)(u8_refNow - u8_refLast);
+        u8_refLast = u8_refNow;
+    }
+
+    uint32_t u32_millisElapsed = millis() - u32_startTime;
+    uint32_t u32_refElapsed = u32_refTicks * 2048 / 1000;
+
+    TCCR1 = 0;
+    bitSetMask(PRR, _BV(PRTIM1));                                 // Disable TIMER1 clock again
+
+    anim_blk_flash_chars("LOST-MS");
+    anim_blk_print_dec_u32((u32_refElapsed > u32_millisElapsed) ? (u32_refElapsed - u32_millisElapsed) : 0);
+}
+
+#endif /* DEBUG_MILLIS_DRIFT_EN */
+
 #endif /* #ifndef COMPILE_EEP_DATA_WRITE */
\ No newline at end of file
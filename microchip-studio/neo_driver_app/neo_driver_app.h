@@ -27,12 +27,13 @@ extern "C"{
 typedef enum { SYS_MODE_ANIM_SEL,       // Play one selected animation.
                SYS_MODE_ANIM_SHUFF,     // "Shuffle mode". Play randomly selected animations in turn.
                SYS_MODE_PIX_ADJ,        // Adjust number of pixels.
+               SYS_MODE_TIME_SET,       // Set the soft RTC time of day, follows SYS_MODE_PIX_ADJ.
 } _SYS_MODE_T;
 
 /********************************** STRUCTS **********************************/
 
 /********************************** DEFINES **********************************/
-// Watchdog timeouts (Actual delays will be slightly longer at 3.3V)
+// Watchdog timeouts (Actual delays will be slightly longer at 3.3V, see WDT_CAL_XXX)
 #define WDT_16MS   (0)
 #define WDT_32MS   (1)
 #define WDT_64MS   (2)
@@ -44,6 +45,9 @@ typedef enum { SYS_MODE_ANIM_SEL,       // Play one selected animation.
 #define WDT_4S     (8)
 #define WDT_8S     (9)  // Hardware maximum
 
+// Nominal duration of a hardware timeout, WDT_16MS to WDT_8S
+#define WDT_MSEC(t)  (16U << (t))
+
 // Multiples of 8 sec, software generated
 #define WDT_16S    (10)
 #define WDT_24S    (11)
@@ -52,11 +56,63 @@ typedef enum { SYS_MODE_ANIM_SEL,       // Play one selected animation.
 #define WDT_48S    (14)
 #define WDT_56S    (15)
 
+// Watchdog calibration. The WDT oscillator period is measured against Timer0 and stored in EEP_SETT_WDT_CAL, as
+// usec per nominal 16 msec period. Sleeps are composed from the steps at their measured length.
+#define WDT_CAL_NOMINAL_USEC  (16000)
+#define WDT_CAL_MIN_USEC      (12000)     // Outside this range (blank EEPROM), use the nominal period
+#define WDT_CAL_MAX_USEC      (24000)
+#define WDT_CAL_STEP          (WDT_250MS) // Timeout measured, 2000 Timer0 ticks at the 128 usec resolution
+#define WDT_CAL_CYCLES        (16)        // Measure again every this many anim cycles, power of 2
+#define WDT_CAL_DRIFT_DIV     (100)       // Only rewrite EEPROM if the period moved by more than 1/100
+
 // Battery params
 #define BATT_TON_MSEC         (2000)    // "On" time for low battery timer
 #define BATT_DISCHG_THRESH_MV (2500)    // Discharge threshold (Cutoff volt. from datasheet = 2.0V)
 #define BATT_CHG_THRESH_MV    (3000)    // Charge threshold (Cutoff volt. from datasheet = 2.0V)
 
+// System clock between shows (mode logic, rendering, idle sleep). np_show() transmits at F_CPU regardless.
+#define SYS_CLK_SLOW_EN
+#ifdef SYS_CLK_SLOW_EN
+    #define SYS_CLK_IDLE  (CLK_SEL_1MHZ)
+#else
+    #define SYS_CLK_IDLE  (CLK_SEL_8MHZ)
+#endif
+
+// Power down between frames of animations that declare a coarse frame period (see u8_frameWdt).
+// Timer0 stops in power-down, the watchdog times the sleep and millis() is advanced by it.
+#define FRAME_PWR_DOWN_EN
+
+// Gate off the NeoPixel power while the strip is black until the next frame, for at least this long.
+// Restarting costs NP_PWR_SETTLE_MSEC of delay and recharging the pixel decoupling caps.
+#define NP_PWR_GATE_EN
+#define NP_PWR_GATE_MIN_MSEC  (50)
+
+// Energy budget sleep scheduler. After each animation cycle, pick the sleep so that the average current meets the
+// runtime target, instead of the animation's fixed u8_nextSleepTime.
+#define ENERGY_SCHED_EN
+#define ENERGY_BATT_CAP_MAH      (500)    // Usable capacity of the LiFePO4 cell
+#define ENERGY_TARGET_DAYS       (14)     // Runtime target on a charge
+#define ENERGY_TARGET_SEC        (ENERGY_TARGET_DAYS * 86400UL)
+#define ENERGY_TARGET_UA         (ENERGY_BATT_CAP_MAH * 1000UL / (ENERGY_TARGET_DAYS * 24UL))  // Average current
+#define ENERGY_ON_UA             (6000)   // MCU and pixel quiescent current while an animation plays
+#define ENERGY_LED_NA_PER_LEVEL  (47)     // LED current per unit of np_get_level(), ~12 mA per channel at 255
+#define ENERGY_SLEEP_UA          (5)      // Power-down with the WDT running, LEDs and pot off
+#define ENERGY_TREND_WINDOW_SEC  (21600)  // Vcc trend window, 6 hours
+#define ENERGY_GAIN_ONE          (128)    // Sleep gain of 1.0
+#define ENERGY_GAIN_MIN          (64)
+#define ENERGY_GAIN_MAX          (255)
+
+// Soft RTC and daily on-window. The clock follows millis() while awake and the calibrated watchdog while asleep.
+// Its time of day is unknown at power on, and is taken to be RTC_ON_START_MIN: by default the window starts when
+// first switched on. Set the time in SYS_MODE_TIME_SET to pin the window to the time of day instead.
+// Outside the window, anim cycles are followed by a sleep to its start. A switch still wakes for one cycle.
+#define RTC_SCHED_EN
+#define RTC_MIN_PER_DAY       (1440)
+#define RTC_ON_START_MIN      (17 * 60) // Window start, minutes after midnight
+#define RTC_ON_WINDOW_MIN     (6 * 60)  // Window length, minutes
+#define RTC_SET_STEP_MIN      (15)      // Time set step per click
+#define RTC_RUNTIME_SAVE_MIN  (15)      // EEP_SETT_RUNTIME_MIN update interval, minutes
+
 // Animation params
 #define ANIM_CNT               (sizeof(apfn_renderFunc) / sizeof(apfn_renderFunc[0]))
 #define ANIM_MANUAL_CYCLES     (1)  // Number of cycles to play in "manual" mode before going to shuffle mode
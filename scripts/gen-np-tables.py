@@ -0,0 +1,137 @@
+# File:    gen-np-tables.py
+# Author:  Garrett Carter
+# Purpose: Generate the flash lookup tables for the NeoPixel library (sine, gamma, and gamma-corrected hue wheel).
+#          Run by the Microchip Studio pre-build event. The gamma exponent and hue table size are build
+#          parameters, set by the NpTableGamma and NpHueTableSize properties in neo_driver_app.cproj.
+#
+# Usage:   python gen-np-tables.py --gamma 2.6 --hue-size 256 --out-dir <path to libs>
+
+import argparse
+import math
+import os
+
+OUT_BASE_NAME = "neo_pixel_tables"
+
+
+def sine_table():
+    return [int((math.sin(x / 128.0 * math.pi) + 1.0) * 127.5 + 0.5) for x in range(256)]
+
+
+def gamma_table(gamma):
+    return [int(math.pow(x / 255.0, gamma) * 255.0 + 0.5) for x in range(256)]
+
+
+# Same integer math as np_hsv_to_pack() with full saturation and value
+def hue_to_rgb(hue):
+    hue = (hue * 1530 + 32768) // 65536
+    if hue < 255:
+        return (255, hue, 0)
+    if hue < 510:
+        return (510 - hue, 255, 0)
+    if hue < 765:
+        return (0, 255, hue - 510)
+    if hue < 1020:
+        return (0, 1020 - hue, 255)
+    if hue < 1275:
+        return (hue - 1020, 0, 255)
+    if hue < 1530:
+        return (255, 0, 1530 - hue)
+    return (255, 0, 0)
+
+
+def hue_gamma_table(size, gamma):
+    g = gamma_table(gamma)
+    table = []
+    for idx in range(size):
+        table.extend(g[c] for c in hue_to_rgb(idx * 65536 // size))
+    return table
+
+
+# C expression mapping a 16-bit hue to a table index, floor(hue * size / 65536), without a multiply or divide.
+# Supported sizes are 2^k and 3 * 2^k.
+def hue_index_expr(size):
+    k = size.bit_length() - 1
+    if size == (1 << k):
+        return "((uint16_t)(h) >> {})".format(16 - k)
+
+    k = (size // 3).bit_length() - 1
+    if size == 3 * (1 << k):
+        return "((uint16_t)(((uint32_t)(h) + ((uint32_t)(h) << 1)) >> {}))".format(16 - k)
+
+    raise SystemExit("Hue table size must be 2^k or 3 * 2^k, got {}".format(size))
+
+
+def format_rows(values, per_row):
+    rows = []
+    for start in range(0, len(values), per_row):
+        rows.append("    " + ",".join("{:3}".format(v) for v in values[start:start + per_row]))
+    return ",\n".join(rows)
+
+
+def write_if_changed(path, text):
+    if os.path.exists(path):
+        with open(path, "r", newline="") as f:
+            if f.read() == text:
+                return
+    with open(path, "w", newline="\n") as f:
+        f.write(text)
+    print("Wrote " + path)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--gamma", type=float, default=2.6, help="Gamma correction exponent")
+    parser.add_argument("--hue-size", type=int, default=256, help="Entries in the hue wheel table, 2^k or 3 * 2^k")
+    parser.add_argument("--out-dir", default=os.path.join(os.path.dirname(__file__), "..", "microchip-studio", "neo_driver_app", "libs"))
+    args = parser.parse_args()
+
+    index_expr = hue_index_expr(args.hue_size)
+    banner = ("/* File:      {}\n"
+              " * Author:    Generated by scripts/gen-np-tables.py --gamma {} --hue-size {}. Do not edit.\n"
+              " * Purpose:   Flash lookup tables for the NeoPixel library\n"
+              " */\n")
+
+    header = (banner.format(OUT_BASE_NAME + ".h", args.gamma, args.hue_size) +
+              "\n"
+              "#ifndef NEOPIXEL_TABLES_H\n"
+              "#define NEOPIXEL_TABLES_H\n"
+              "\n"
+              "#include <stdint.h>\n"
+              "#include <avr/pgmspace.h>\n"
+              "\n"
+              "/****************************** DEFINES ******************************/\n"
+              "#define NP_TABLE_GAMMA_X100       ({})\n"
+              "#define NP_HUE_TABLE_SIZE         ({})\n"
+              "// Table index for a 16-bit hue: floor(hue * NP_HUE_TABLE_SIZE / 65536)\n"
+              "#define NP_HUE_TABLE_INDEX(h)     {}\n"
+              "\n"
+              "/*************************** FLASH CONSTANTS ***************************/\n"
+              "extern const uint8_t PROGMEM _au8_NeoPixelSineTable[256];\n"
+              "extern const uint8_t PROGMEM _au8_NeoPixelGammaTable[256];\n"
+              "// R,G,B of each fully saturated hue, gamma corrected\n"
+              "extern const uint8_t PROGMEM _au8_NeoPixelHueGammaTable[NP_HUE_TABLE_SIZE * 3];\n"
+              "\n"
+              "#endif /* NEOPIXEL_TABLES_H */\n").format(int(round(args.gamma * 100)), args.hue_size, index_expr)
+
+    source = (banner.format(OUT_BASE_NAME + ".c", args.gamma, args.hue_size) +
+              "\n"
+              "#include \"neo_pixel_tables.h\"\n"
+              "\n"
+              "// 8-bit unsigned sine wave (0-255), one full circle\n"
+              "const uint8_t PROGMEM _au8_NeoPixelSineTable[256] = {{\n{}\n}};\n"
+              "\n"
+              "// 8-bit gamma correction, exponent {}\n"
+              "const uint8_t PROGMEM _au8_NeoPixelGammaTable[256] = {{\n{}\n}};\n"
+              "\n"
+              "// Gamma-corrected hue wheel, {} entries of R,G,B. Entry i is hue i * 65536 / {}.\n"
+              "const uint8_t PROGMEM _au8_NeoPixelHueGammaTable[NP_HUE_TABLE_SIZE * 3] = {{\n{}\n}};\n").format(
+                  format_rows(sine_table(), 16),
+                  args.gamma, format_rows(gamma_table(args.gamma), 16),
+                  args.hue_size, args.hue_size, format_rows(hue_gamma_table(args.hue_size, args.gamma), 12))
+
+    write_if_changed(os.path.join(args.out_dir, OUT_BASE_NAME + ".h"), header)
+    write_if_changed(os.path.join(args.out_dir, OUT_BASE_NAME + ".c"), source)
+
+
+if __name__ == "__main__":
+    main()